@@ -0,0 +1,117 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the attack info of a position, which is shared by
+ * everything that needs to know what is attacked, checks and pins.
+ */
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+/* Add the attacks of one piece, keeping track of squares attacked twice */
+static inline void
+add_attacks(Attack_Info *ai, Turn t, Piece_Type pt, Bitboard a) {
+	ai->twice[t] |= ai->by_type[t][ALL_PIECES] & a;
+	ai->by_type[t][ALL_PIECES] |= a;
+	ai->by_type[t][pt] |= a;
+}
+
+/* Find the sliders lined up with side t's king and what stands in between */
+static void
+find_pins(Board *board, Attack_Info *ai, Turn t) {
+	Bitboard occ = board->pieces[ALL_PIECES];
+	Square king = lsb(board->pieces[KING] & board->sides[t]);
+
+	Bitboard rooks   = board->pieces[ROOK]   | board->pieces[QUEEN];
+	Bitboard bishops = board->pieces[BISHOP] | board->pieces[QUEEN];
+
+	Bitboard snipers = board->sides[!t] &
+		((get_rook_attacks(king, 0ULL) & rooks) |
+		 (get_bishop_attacks(king, 0ULL) & bishops));
+
+	while (snipers) {
+		Square s = lsb(snipers);
+		Bitboard sniper = 1ULL << s;
+		Bitboard blockers = between(king, s) & occ;
+
+		if (blockers && !(blockers & (blockers - 1))) {
+			ai->blockers[t] |= blockers;
+			if (blockers & board->sides[t])
+				ai->pinners[!t] |= sniper;
+		}
+
+		snipers &= snipers - 1;
+	}
+}
+
+void
+compute_attack_info(Board *board, Attack_Info *ai) {
+	Bitboard occ = board->pieces[ALL_PIECES];
+
+	for (Turn t = WHITE; t <= BLACK; t++) {
+		for (Piece_Type pt = ALL_PIECES; pt <= KING; pt++)
+			ai->by_type[t][pt] = 0ULL;
+
+		ai->twice[t] = ai->pinners[t] = ai->blockers[t] = 0ULL;
+	}
+
+	for (Turn t = WHITE; t <= BLACK; t++) {
+		for (Piece_Type pt = PAWN; pt <= KING; pt++) {
+			Bitboard b = board->pieces[pt] & board->sides[t];
+
+			while (b) {
+				Square sq = lsb(b);
+				Bitboard a;
+
+				switch (pt) {
+					case PAWN:   a = get_pawn_attacks(sq, t);     break;
+					case KNIGHT: a = get_knight_attacks(sq);      break;
+					case BISHOP: a = get_bishop_attacks(sq, occ); break;
+					case ROOK:   a = get_rook_attacks(sq, occ);   break;
+					case QUEEN:  a = get_queen_attacks(sq, occ);  break;
+					default:     a = get_king_attacks(sq);        break;
+				}
+
+				add_attacks(ai, t, pt, a);
+				b &= b - 1;
+			}
+		}
+
+		find_pins(board, ai, t);
+	}
+
+	for (Turn t = WHITE; t <= BLACK; t++) {
+		Bitboard *enemy = ai->by_type[!t];
+
+		/* Attacks by pieces worth less than a minor, a rook and a queen */
+		Bitboard below_minor = enemy[PAWN];
+		Bitboard below_rook  = below_minor | enemy[KNIGHT] | enemy[BISHOP];
+		Bitboard below_queen = below_rook  | enemy[ROOK];
+
+		ai->threatened[t] = board->sides[t] &
+			((below_minor & (board->pieces[KNIGHT] | board->pieces[BISHOP])) |
+			 (below_rook  & board->pieces[ROOK]) |
+			 (below_queen & board->pieces[QUEEN]));
+	}
+
+	Square king = lsb(board->pieces[KING] & board->sides[board->turn]);
+	ai->checkers = attackers_to(board, king, occ) & board->sides[!board->turn];
+
+	ai->valid = true;
+}
@@ -20,7 +20,6 @@
  */
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <assert.h>
 
 #include "defs.h"
@@ -36,6 +35,16 @@ Bitboard king_attacks[SQ_CNT];
 Magic rook_magics[SQ_CNT];
 Magic bishop_magics[SQ_CNT];
 
+/*
+ * All of the magic attack tables share one block, each square gets 2^bits
+ * entries of it where bits is the amount of squares in its mask.
+ */
+#define ROOK_TABLE_SIZE   102400
+#define BISHOP_TABLE_SIZE 5248
+
+static Bitboard slider_table[ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE]
+	__attribute__((aligned(64)));
+
 /* 
  * Initialize bitboards used for shift checking
  * See piece_shift in "board/helpers.h"
@@ -146,6 +155,7 @@ gen_sliding_attacks() {
 
 	Square sq;
 	Bitboard occ;
+	Bitboard *next = slider_table;
 
 	init_magic_numbers();
 
@@ -164,28 +174,32 @@ gen_sliding_attacks() {
 		rook_magics[sq].shift   = 64 - popcnt(rook_magics[sq].mask);
 		bishop_magics[sq].shift = 64 - popcnt(bishop_magics[sq].mask);
 
-		rook_magics[sq].attacks =
-			malloc((1ULL << popcnt(rook_magics[sq].mask))   * 8);
-		bishop_magics[sq].attacks =
-			malloc((1ULL << popcnt(bishop_magics[sq].mask)) * 8);
+		rook_magics[sq].attacks   = next;
+		next += 1ULL << popcnt(rook_magics[sq].mask);
+		bishop_magics[sq].attacks = next;
+		next += 1ULL << popcnt(bishop_magics[sq].mask);
 
 		/*
-		 * This loops over all relevant occupancies and writes the attack for
-		 * that case into the attacks table
+		 * This loops over all relevant occupancies, including the empty one,
+		 * and writes the attack for that case into the attacks table
 		 */
 
-		occ = rook_magics[sq].mask;
+		occ = 0ULL;
 		do {
 			rook_magics[sq].attacks[rook_index(sq, occ)] =
 				get_sliding_attack(sq, occ, rook_dirs);
-		} while ((occ = (occ - 1) & rook_magics[sq].mask));
+		} while ((occ = (occ - rook_magics[sq].mask) &
+			rook_magics[sq].mask));
 
-		occ = bishop_magics[sq].mask;
+		occ = 0ULL;
 		do {
 			bishop_magics[sq].attacks[bishop_index(sq, occ)] =
 				get_sliding_attack(sq, occ, bishop_dirs);
-		} while ((occ = (occ - 1) & bishop_magics[sq].mask));
+		} while ((occ = (occ - bishop_magics[sq].mask) &
+			bishop_magics[sq].mask));
 	}
+
+	assert(next == slider_table + ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE);
 }
 
 void
@@ -195,6 +209,8 @@ init_attacks() {
 	gen_knight_attacks();
 	gen_king_attacks();
 	gen_sliding_attacks();
+	init_kogge_stone();
+	init_zobrist();
 }
 
 Bitboard
@@ -235,3 +251,44 @@ get_queen_attacks(Square sq, Bitboard occ) {
 		bishop_magics[sq].attacks[bishop_index(sq, occ)];
 }
 
+
+/*
+ * Get the squares strictly between two squares on a line, or nothing if they
+ * aren't on one. Those are the squares attacked from both ends with the
+ * other end as the only blocker.
+ */
+Bitboard
+between(Square a, Square b) {
+	Bitboard bb = 1ULL << b;
+
+	if (get_rook_attacks(a, 0ULL) & bb)
+		return get_rook_attacks(a, bb) & get_rook_attacks(b, 1ULL << a);
+
+	if (get_bishop_attacks(a, 0ULL) & bb)
+		return get_bishop_attacks(a, bb) & get_bishop_attacks(b, 1ULL << a);
+
+	return 0ULL;
+}
+
+/* Get the pieces of both sides that attack a square with this occupancy */
+Bitboard
+attackers_to(Board *board, Square sq, Bitboard occ) {
+	Bitboard queens = board->pieces[QUEEN];
+
+	return (get_pawn_attacks(sq, BLACK) & board->pieces[PAWN] &
+	        board->sides[WHITE]) |
+	       (get_pawn_attacks(sq, WHITE) & board->pieces[PAWN] &
+	        board->sides[BLACK]) |
+	       (get_knight_attacks(sq) & board->pieces[KNIGHT]) |
+	       (get_king_attacks(sq) & board->pieces[KING]) |
+	       (get_rook_attacks(sq, occ) & (board->pieces[ROOK] | queens)) |
+	       (get_bishop_attacks(sq, occ) & (board->pieces[BISHOP] | queens));
+}
+
+bool
+in_check(Board *board) {
+	Square king = lsb(board->pieces[KING] & board->sides[board->turn]);
+
+	return attackers_to(board, king, board->pieces[ALL_PIECES]) &
+		board->sides[!board->turn];
+}
@@ -34,7 +34,7 @@
 
 void
 clear_board(Board *board) {
-	for (Piece_Type p = PAWN; p <= KING; p++)
+	for (Piece_Type p = ALL_PIECES; p <= KING; p++)
 		board->pieces[p] = 0ULL;
 
 	for (Turn t = WHITE; t <= BLACK; t++)
@@ -49,6 +49,8 @@ clear_board(Board *board) {
 	board->en_pas_square = NO_SQ;
 
 	board->half_move_cnt = 0;
+
+	board->key = 0ULL;
 }
 
 void
@@ -176,6 +178,10 @@ parse_fen(Board *board, const char *str) {
 				board->castle_perms |= CASTLE_BLACK_QUEEN;
 				break;
 
+			/* Nobody can castle */
+			case '-':
+				break;
+
 			default:
 				FEN_ERROR();
 				break;
@@ -215,6 +221,8 @@ parse_fen(Board *board, const char *str) {
 
 
 	/* At the end there will be a full move counter but that isn't needed */
+
+	board->key = board_key(board);
 }
 
 #ifdef DEBUG
@@ -237,7 +245,8 @@ print_board(Board *board) {
 			printf("|");
 	}
 	printf(" 1\n\n  A B C D E F G H\n\n");
-	printf("%s to move\n\n", board->turn == WHITE ? "White" : "Black");
+	printf("%s to move\n", board->turn == WHITE ? "White" : "Black");
+	printf("Key %016llx\n\n", (unsigned long long)board->key);
 }
 
 void
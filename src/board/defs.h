@@ -16,19 +16,37 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "../defs.h"
 
 #define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
 extern Bitboard allowed_squares_by_dir[36];
 
+typedef uint64_t Key;
+
+extern Key zobrist_pieces[PIECE_CNT][SQ_CNT];
+extern Key zobrist_castle[16];
+extern Key zobrist_en_pas[FILE_CNT];
+extern Key zobrist_turn;
+
+/*
+ * The board is copied once per node by copy_make_move, so it is kept small
+ * and aligned to cache lines. The bitboards and the key come first, then the
+ * small state fields and the mailbox, 192 bytes in all.
+ */
 typedef struct {
+	/* pieces[ALL_PIECES] has every occupied square */
 	Bitboard pieces[PIECE_TYPE_CNT];
 	Bitboard sides[TURN_CNT];
 
-	Piece mailbox[SQ_CNT];
+	/* Zobrist key, kept up to date by place_piece, remove_piece and make */
+	Key key;
 
-	Turn turn;
+	/* A Turn */
+	uint8_t turn;
 
 	/*
 	 * Four bits are used to represent castling perms
@@ -37,11 +55,90 @@ typedef struct {
 	 */
 	Castling_Perm castle_perms;
 
-	Square en_pas_square;
+	/* A Square, NO_SQ when there is none */
+	uint8_t en_pas_square;
 
 	/* Max is 50 for 50 move rule so uint8 is fine */
 	uint8_t half_move_cnt;
-} Board;
+
+	/* Pieces fit in a byte, so this is a Piece per square */
+	uint8_t mailbox[SQ_CNT];
+} __attribute__((aligned(CACHE_LINE_SIZE))) Board;
+
+_Static_assert(sizeof(Board) == 3 * CACHE_LINE_SIZE, "Board should be 3 lines");
+
+/*
+ * A position packed into 32 bytes, see "board/pack.c". Files of these are
+ * written in the byte order of the machine.
+ */
+typedef struct {
+	Bitboard occupancy;
+
+	/* The piece on each occupied square in order, two to a byte */
+	uint8_t pieces[16];
+
+	/* Bit 0 is the turn and bits 1-4 the castling perms */
+	uint8_t state;
+	uint8_t en_pas_square;
+	uint8_t half_move_cnt;
+
+	/* For training data, 0 for a black win, 1 for a draw, 2 for a white win */
+	uint8_t result;
+
+	uint8_t reserved[4];
+} Packed_Board;
+
+_Static_assert(sizeof(Packed_Board) == 32, "Packed_Board should be 32 bytes");
+
+/* A file of packed boards mapped into memory */
+typedef struct {
+	const Packed_Board *records;
+	size_t cnt;
+} Packed_File;
+
+/* Called for every record of a file by decode_packed_file */
+typedef void (*Packed_Fn)(Board *board, uint8_t result, size_t index,
+                          void *arg);
+
+typedef uint16_t Move;
+
+#define NO_MOVE 0
+
+/* Everything that can't be worked out again when undoing a move */
+typedef struct {
+	Piece captured;
+	Castling_Perm castle_perms;
+	Square en_pas_square;
+	uint8_t half_move_cnt;
+	Key key;
+} Undo;
+
+/*
+ * Everything about which squares are attacked in a position. Working it out
+ * takes a slider lookup per piece, so it is done at most once per node, the
+ * first time anything asks for it, see get_attack_info in "helpers.h".
+ */
+typedef struct {
+	/* by_type[t][ALL_PIECES] is every square side t attacks */
+	Bitboard by_type[TURN_CNT][PIECE_TYPE_CNT];
+
+	/* Squares side t attacks with at least two pieces */
+	Bitboard twice[TURN_CNT];
+
+	/* Pieces of side t attacked by an enemy piece worth less */
+	Bitboard threatened[TURN_CNT];
+
+	/* Pieces giving check to the side to move */
+	Bitboard checkers;
+
+	/* Sliders of side t pinning a piece to the enemy king */
+	Bitboard pinners[TURN_CNT];
+
+	/* Pieces of either side that are alone between side t's king and a slider */
+	Bitboard blockers[TURN_CNT];
+
+	bool valid;
+} Attack_Info;
 
 typedef struct {
 	uint64_t magic;
@@ -63,11 +160,36 @@ enum {
 
 void clear_board(Board *board);
 void parse_fen(Board *board, const char *str);
+
+bool pack_board(Board *board, uint8_t result, Packed_Board *pb);
+bool unpack_board(const Packed_Board *pb, Board *board);
+bool open_packed_file(Packed_File *pf, const char *path);
+void close_packed_file(Packed_File *pf);
+size_t decode_packed_file(Packed_File *pf, int thread_cnt, Packed_Fn f,
+                          void *arg);
+
+void init_zobrist();
+Key board_key(Board *board);
+Move cuckoo_move(Key diff);
+
+void make_move(Board *board, Move move, Undo *undo);
+void undo_move(Board *board, Move move, Undo *undo);
+void make_null_move(Board *board, Undo *undo);
+void undo_null_move(Board *board, Undo *undo);
+void copy_make_move(const Board *board, Board *child, Move move);
+void bench_make();
+Move parse_move(const char *str);
+void move_str(Move move, char *str);
 #ifdef DEBUG
 void print_board(Board *board);
 void print_bitboard(Bitboard b);
 #endif
 
+int gen_moves(Board *board, Move *moves);
+int gen_captures(Board *board, Move *moves);
+bool left_in_check(Board *board);
+bool is_legal_move(Board *board, Move move);
+
 void init_attacks();
 Bitboard get_pawn_attacks(Square sq, Turn t);
 Bitboard get_knight_attacks(Square sq);
@@ -75,3 +197,12 @@ Bitboard get_king_attacks(Square sq);
 Bitboard get_rook_attacks(Square sq, Bitboard occ);
 Bitboard get_bishop_attacks(Square sq, Bitboard occ);
 Bitboard get_queen_attacks(Square sq, Bitboard occ);
+Bitboard attackers_to(Board *board, Square sq, Bitboard occ);
+bool in_check(Board *board);
+Bitboard between(Square a, Square b);
+void compute_attack_info(Board *board, Attack_Info *ai);
+
+void init_kogge_stone();
+Bitboard get_slider_attacks(Bitboard rooks, Bitboard bishops, Bitboard occ);
+Bitboard get_side_slider_attacks(Board *board, Turn t);
+void bench_sliders();
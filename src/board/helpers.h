@@ -14,6 +14,7 @@
  * You should have recieved a copy of the GNU General Public License
  * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
  */
+#pragma once
 
 #include <assert.h>
 #include <stdbool.h>
@@ -85,11 +86,57 @@ piece_side(Piece p) {
 static inline void
 place_piece(Board *board, Piece p, Square s) {
 	board->mailbox[s] = p;
+	board->key ^= zobrist_pieces[p][s];
 
+	board->pieces[ALL_PIECES]    |= 1ULL << s;
 	board->pieces[piece_type(p)] |= 1ULL << s;
 	board->sides [piece_side(p)] |= 1ULL << s;
 }
 
+static inline void
+remove_piece(Board *board, Square s) {
+	Piece p = board->mailbox[s];
+
+	board->mailbox[s] = NO_PIECE;
+	board->key ^= zobrist_pieces[p][s];
+
+	board->pieces[ALL_PIECES]    &= ~(1ULL << s);
+	board->pieces[piece_type(p)] &= ~(1ULL << s);
+	board->sides [piece_side(p)] &= ~(1ULL << s);
+}
+
+static inline Piece
+make_piece(Piece_Type pt, Turn t) {
+	return pt | t << 3;
+}
+
+
+
+/*
+ * Moves are stored in 16 bits, 6 for the from square, 6 for the to square
+ * and 3 for the piece type that a pawn promotes to.
+ */
+
+static inline Move
+new_move(Square from, Square to, Piece_Type promo) {
+	return from | to << 6 | promo << 12;
+}
+
+static inline Square
+move_from(Move m) {
+	return m & 63;
+}
+
+static inline Square
+move_to(Move m) {
+	return (m >> 6) & 63;
+}
+
+static inline Piece_Type
+move_promo(Move m) {
+	return (m >> 12) & 7;
+}
+
 
 
 static inline uint8_t
@@ -97,6 +144,34 @@ popcnt(Bitboard b) {
 	return __builtin_popcountll(b);
 }
 
+/* Index of the least significant bit, b must not be empty */
+static inline Square
+lsb(Bitboard b) {
+	assert(b);
+	return __builtin_ctzll(b);
+}
+
+/* Amount of king moves needed to get from one square to another */
+static inline uint8_t
+distance(Square a, Square b) {
+	int df = file(a) > file(b) ? file(a) - file(b) : file(b) - file(a);
+	int dr = rank(a) > rank(b) ? rank(a) - rank(b) : rank(b) - rank(a);
+	return df > dr ? df : dr;
+}
+
+/* Get the attack info of a position, working it out if it hasn't been yet */
+static inline Attack_Info *
+get_attack_info(Board *board, Attack_Info *ai) {
+	if (!ai->valid)
+		compute_attack_info(board, ai);
+	return ai;
+}
+
+/* Has to be called whenever the board the info belongs to changes */
+static inline void
+clear_attack_info(Attack_Info *ai) {
+	ai->valid = false;
+}
 
 /* Bitboards for a rank and file */
 static inline Bitboard
@@ -0,0 +1,316 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains a second, table free backend for sliding piece attacks
+ * using Kogge-Stone occluded fills.
+ *
+ * Instead of looking up one square at a time like the magic tables in
+ * attacks.c, every slider of a side is flooded at once, so the result is the
+ * union of the attacks of all of them. That is what evaluation and SEE want,
+ * and since there are no tables it does not compete with the hash for cache.
+ *
+ * The eight ray directions are independent of each other, so when the cpu
+ * supports it they are all computed together in vector registers: two AVX2
+ * registers of four directions each, or a single AVX-512 register. The
+ * backend is picked at runtime so the binary still runs everywhere. Other
+ * architectures only get the scalar version.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_SIMD
+#include <immintrin.h>
+#endif
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+#define NOT_FILE_A 0xFEFEFEFEFEFEFEFEULL
+#define NOT_FILE_H 0x7F7F7F7F7F7F7F7FULL
+
+/*
+ * The eight directions as shift amounts. The first four shift left and the
+ * last four shift right, the rook directions are 0, 1, 4 and 5.
+ */
+static const uint64_t ray_shifts[8] = { 1, 8, 9, 7, 1, 8, 9, 7 };
+
+/* Squares that are not allowed after a shift, so rays don't wrap around */
+static const uint64_t ray_masks[8] = {
+	NOT_FILE_A, ~0ULL, NOT_FILE_A, NOT_FILE_H,
+	NOT_FILE_H, ~0ULL, NOT_FILE_H, NOT_FILE_A
+};
+
+/* Scalar */
+
+static inline Bitboard
+ray_shift(Bitboard b, int dir, int steps) {
+	return dir < 4 ?
+		b << ray_shifts[dir] * steps :
+		b >> ray_shifts[dir] * steps;
+}
+
+/*
+ * Fill from gen along one direction through the empty squares, doubling the
+ * distance every step, then shift once more to include the blocker.
+ */
+static inline Bitboard
+occluded_attacks(Bitboard gen, Bitboard empty, int dir) {
+	Bitboard pro = empty & ray_masks[dir];
+
+	gen |= pro & ray_shift(gen, dir, 1);
+	pro &= ray_shift(pro, dir, 1);
+	gen |= pro & ray_shift(gen, dir, 2);
+	pro &= ray_shift(pro, dir, 2);
+	gen |= pro & ray_shift(gen, dir, 4);
+
+	return ray_shift(gen, dir, 1) & ray_masks[dir];
+}
+
+static Bitboard
+slider_attacks_scalar(Bitboard rooks, Bitboard bishops, Bitboard occ) {
+	Bitboard r = 0ULL;
+
+	for (int dir = 0; dir < 8; dir++) {
+		bool rook_dir = (dir & 3) < 2;
+		r |= occluded_attacks(rook_dir ? rooks : bishops, ~occ, dir);
+	}
+
+	return r;
+}
+
+#ifdef HAVE_SIMD
+
+/* AVX2, the left and right shifting directions each get a register */
+
+__attribute__((target("avx2"))) static inline __m256i
+fill_avx2(__m256i gen, __m256i pro, __m256i s, bool left) {
+	__m256i s2 = _mm256_add_epi64(s, s);
+	__m256i s4 = _mm256_add_epi64(s2, s2);
+
+#define SHIFT(x, n) (left ? _mm256_sllv_epi64(x, n) : _mm256_srlv_epi64(x, n))
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, SHIFT(gen, s)));
+	pro = _mm256_and_si256(pro, SHIFT(pro, s));
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, SHIFT(gen, s2)));
+	pro = _mm256_and_si256(pro, SHIFT(pro, s2));
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, SHIFT(gen, s4)));
+
+	return SHIFT(gen, s);
+#undef SHIFT
+}
+
+__attribute__((target("avx2"))) static Bitboard
+slider_attacks_avx2(Bitboard rooks, Bitboard bishops, Bitboard occ) {
+	__m256i gen = _mm256_setr_epi64x(rooks, rooks, bishops, bishops);
+	__m256i empty = _mm256_set1_epi64x(~occ);
+
+	__m256i l_shift = _mm256_loadu_si256((const __m256i *)&ray_shifts[0]);
+	__m256i r_shift = _mm256_loadu_si256((const __m256i *)&ray_shifts[4]);
+	__m256i l_mask  = _mm256_loadu_si256((const __m256i *)&ray_masks[0]);
+	__m256i r_mask  = _mm256_loadu_si256((const __m256i *)&ray_masks[4]);
+
+	__m256i l = _mm256_and_si256(l_mask,
+		fill_avx2(gen, _mm256_and_si256(empty, l_mask), l_shift, true));
+	__m256i r = _mm256_and_si256(r_mask,
+		fill_avx2(gen, _mm256_and_si256(empty, r_mask), r_shift, false));
+
+	__m256i a = _mm256_or_si256(l, r);
+	__m128i b = _mm_or_si128(_mm256_castsi256_si128(a),
+		_mm256_extracti128_si256(a, 1));
+
+	/* Going through memory also works on 32 bit x86 */
+	Bitboard lanes[2];
+	_mm_storeu_si128((__m128i *)lanes, b);
+
+	return lanes[0] | lanes[1];
+}
+
+/* AVX-512, all eight directions in one register */
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+AVX512_TARGET static inline __m512i
+shift_avx512(__m512i x, __m512i n) {
+	/* The upper four lanes shift right */
+	return _mm512_mask_srlv_epi64(_mm512_sllv_epi64(x, n), 0xF0, x, n);
+}
+
+AVX512_TARGET static Bitboard
+slider_attacks_avx512(Bitboard rooks, Bitboard bishops, Bitboard occ) {
+	__m512i gen = _mm512_setr_epi64(rooks, rooks, bishops, bishops,
+	                                rooks, rooks, bishops, bishops);
+	__m512i s  = _mm512_loadu_si512(ray_shifts);
+	__m512i s2 = _mm512_add_epi64(s, s);
+	__m512i s4 = _mm512_add_epi64(s2, s2);
+	__m512i mask = _mm512_loadu_si512(ray_masks);
+	__m512i pro = _mm512_and_si512(_mm512_set1_epi64(~occ), mask);
+
+	gen = _mm512_or_si512(gen, _mm512_and_si512(pro, shift_avx512(gen, s)));
+	pro = _mm512_and_si512(pro, shift_avx512(pro, s));
+	gen = _mm512_or_si512(gen, _mm512_and_si512(pro, shift_avx512(gen, s2)));
+	pro = _mm512_and_si512(pro, shift_avx512(pro, s2));
+	gen = _mm512_or_si512(gen, _mm512_and_si512(pro, shift_avx512(gen, s4)));
+
+	return _mm512_reduce_or_epi64(
+		_mm512_and_si512(shift_avx512(gen, s), mask));
+}
+
+#endif
+
+static Bitboard (*slider_attacks)(Bitboard, Bitboard, Bitboard) =
+	slider_attacks_scalar;
+
+void
+init_kogge_stone() {
+	slider_attacks = slider_attacks_scalar;
+
+#ifdef HAVE_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f"))
+		slider_attacks = slider_attacks_avx512;
+	else if (__builtin_cpu_supports("avx2"))
+		slider_attacks = slider_attacks_avx2;
+#endif
+}
+
+/*
+ * Get every square attacked by a set of orthogonal sliders and a set of
+ * diagonal sliders. Queens belong in both sets.
+ */
+Bitboard
+get_slider_attacks(Bitboard rooks, Bitboard bishops, Bitboard occ) {
+	return slider_attacks(rooks, bishops, occ);
+}
+
+/* Get every square attacked by the bishops, rooks and queens of one side */
+Bitboard
+get_side_slider_attacks(Board *board, Turn t) {
+	assert(valid_turn(t));
+
+	Bitboard queens  = board->pieces[QUEEN];
+	Bitboard rooks   = (board->pieces[ROOK]   | queens) & board->sides[t];
+	Bitboard bishops = (board->pieces[BISHOP] | queens) & board->sides[t];
+
+	return slider_attacks(rooks, bishops, board->pieces[ALL_PIECES]);
+}
+
+/*
+ * Benchmark the backends against the magic tables on random positions. The
+ * magic version has to loop over every slider and look each one up.
+ */
+
+#define BENCH_POSITIONS 4096
+#define BENCH_ROUNDS    1000
+
+static uint64_t
+bench_random(uint64_t *seed) {
+	*seed ^= *seed >> 12;
+	*seed ^= *seed << 25;
+	*seed ^= *seed >> 27;
+	return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+static Bitboard
+slider_attacks_magic(Bitboard rooks, Bitboard bishops, Bitboard occ) {
+	Bitboard r = 0ULL;
+
+	while (rooks) {
+		r |= get_rook_attacks(__builtin_ctzll(rooks), occ);
+		rooks &= rooks - 1;
+	}
+	while (bishops) {
+		r |= get_bishop_attacks(__builtin_ctzll(bishops), occ);
+		bishops &= bishops - 1;
+	}
+
+	return r;
+}
+
+static double
+bench_backend(Bitboard (*f)(Bitboard, Bitboard, Bitboard),
+              Bitboard *rooks, Bitboard *bishops, Bitboard *occ,
+              Bitboard *sum) {
+	struct timespec start, end;
+
+	*sum = 0ULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+		for (int i = 0; i < BENCH_POSITIONS; i++)
+			*sum += f(rooks[i], bishops[i], occ[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+void
+bench_sliders() {
+	static Bitboard rooks[BENCH_POSITIONS];
+	static Bitboard bishops[BENCH_POSITIONS];
+	static Bitboard occ[BENCH_POSITIONS];
+
+	struct {
+		const char *name;
+		Bitboard (*f)(Bitboard, Bitboard, Bitboard);
+	} backends[] = {
+		{ "magic",   slider_attacks_magic },
+		{ "scalar",  slider_attacks_scalar },
+#ifdef HAVE_SIMD
+		{ "avx2",    __builtin_cpu_supports("avx2") ?
+			slider_attacks_avx2 : NULL },
+		{ "avx512",  __builtin_cpu_supports("avx512f") ?
+			slider_attacks_avx512 : NULL },
+#endif
+	};
+
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+	/* Sparse random boards with two or three sliders of each kind */
+	for (int i = 0; i < BENCH_POSITIONS; i++) {
+		occ[i] = bench_random(&seed) & bench_random(&seed);
+		rooks[i] = occ[i] & bench_random(&seed) & bench_random(&seed);
+		bishops[i] = occ[i] & bench_random(&seed) & bench_random(&seed) &
+			~rooks[i];
+	}
+
+	Bitboard expected = 0ULL;
+	double magic_ns = 0;
+
+	for (unsigned i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+		Bitboard sum;
+
+		if (!backends[i].f) {
+			printf("%-8s unsupported\n", backends[i].name);
+			continue;
+		}
+
+		double ns = bench_backend(backends[i].f, rooks, bishops, occ, &sum);
+
+		if (i == 0) {
+			expected = sum;
+			magic_ns = ns;
+		}
+
+		printf("%-8s %6.2f ns/call %5.2fx %s\n", backends[i].name,
+			ns / ((double)BENCH_ROUNDS * BENCH_POSITIONS), magic_ns / ns,
+			sum == expected ? "" : "MISMATCH");
+	}
+}
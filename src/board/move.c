@@ -0,0 +1,306 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains functions for making and undoing moves along with
+ * converting them to and from the UCI long algebraic notation.
+ *
+ * Castling and en passant are not marked in the move itself, they are worked
+ * out from the king moving two squares and a pawn moving onto the en passant
+ * square.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+/* The castling perms that stay after a piece moves from or to a square */
+static Castling_Perm
+castle_mask(Square sq) {
+	switch (sq) {
+		case A1: return ~CASTLE_WHITE_QUEEN;
+		case H1: return ~CASTLE_WHITE_KING;
+		case E1: return ~CASTLE_WHITE;
+		case A8: return ~CASTLE_BLACK_QUEEN;
+		case H8: return ~CASTLE_BLACK_KING;
+		case E8: return ~CASTLE_BLACK;
+		default: return ~0;
+	}
+}
+
+/* Move the rook when the king castles */
+static inline void
+castle_rook(Board *board, Square from, Square to) {
+	Square rook_from = to > from ? square(FILE_H, rank(from)) :
+	                               square(FILE_A, rank(from));
+	Square rook_to   = to > from ? from + 1 : from - 1;
+
+	Piece rook = board->mailbox[rook_from];
+	remove_piece(board, rook_from);
+	place_piece(board, rook, rook_to);
+}
+
+void
+make_move(Board *board, Move move, Undo *undo) {
+	Square from = move_from(move);
+	Square to   = move_to(move);
+	Piece p = board->mailbox[from];
+
+	assert(valid_piece(p));
+	assert(piece_side(p) == board->turn);
+
+	undo->captured      = board->mailbox[to];
+	undo->castle_perms  = board->castle_perms;
+	undo->en_pas_square = board->en_pas_square;
+	undo->half_move_cnt = board->half_move_cnt;
+	undo->key           = board->key;
+
+	if (undo->captured)
+		remove_piece(board, to);
+
+	/* En passant, the captured pawn is behind the to square */
+	if (piece_type(p) == PAWN && to == board->en_pas_square) {
+		Square cap = board->turn == WHITE ? to + SOUTH : to + NORTH;
+		undo->captured = board->mailbox[cap];
+		remove_piece(board, cap);
+	}
+
+	remove_piece(board, from);
+	place_piece(board, move_promo(move) ?
+		make_piece(move_promo(move), board->turn) : p, to);
+
+	if (piece_type(p) == KING && distance(from, to) == 2)
+		castle_rook(board, from, to);
+
+	if (board->en_pas_square != NO_SQ)
+		board->key ^= zobrist_en_pas[file(board->en_pas_square)];
+
+	board->en_pas_square = NO_SQ;
+	if (piece_type(p) == PAWN && distance(from, to) == 2 &&
+		file(from) == file(to)) {
+		board->en_pas_square = (from + to) / 2;
+		board->key ^= zobrist_en_pas[file(board->en_pas_square)];
+	}
+
+	board->key ^= zobrist_castle[board->castle_perms];
+	board->castle_perms &= castle_mask(from) & castle_mask(to);
+	board->key ^= zobrist_castle[board->castle_perms];
+
+	if (piece_type(p) == PAWN || undo->captured)
+		board->half_move_cnt = 0;
+	else
+		board->half_move_cnt++;
+
+	board->turn = !board->turn;
+	board->key ^= zobrist_turn;
+}
+
+void
+undo_move(Board *board, Move move, Undo *undo) {
+	Square from = move_from(move);
+	Square to   = move_to(move);
+
+	board->turn = !board->turn;
+
+	Piece p = move_promo(move) ?
+		make_piece(PAWN, board->turn) : board->mailbox[to];
+
+	remove_piece(board, to);
+	place_piece(board, p, from);
+
+	if (piece_type(p) == KING && distance(from, to) == 2) {
+		/* Put the rook back by castling again the other way around */
+		Square rook_from = to > from ? from + 1 : from - 1;
+		Square rook_to   = to > from ? square(FILE_H, rank(from)) :
+		                               square(FILE_A, rank(from));
+
+		Piece rook = board->mailbox[rook_from];
+		remove_piece(board, rook_from);
+		place_piece(board, rook, rook_to);
+	}
+
+	if (undo->captured) {
+		Square cap = to;
+
+		if (piece_type(p) == PAWN && to == undo->en_pas_square)
+			cap = board->turn == WHITE ? to + SOUTH : to + NORTH;
+
+		place_piece(board, undo->captured, cap);
+	}
+
+	board->castle_perms  = undo->castle_perms;
+	board->en_pas_square = undo->en_pas_square;
+	board->half_move_cnt = undo->half_move_cnt;
+	board->key           = undo->key;
+}
+
+/*
+ * Pass the turn to the other side, which search uses to see if a position is
+ * still good enough after giving the opponent a free move.
+ */
+void
+make_null_move(Board *board, Undo *undo) {
+	undo->captured      = NO_PIECE;
+	undo->castle_perms  = board->castle_perms;
+	undo->en_pas_square = board->en_pas_square;
+	undo->half_move_cnt = board->half_move_cnt;
+	undo->key           = board->key;
+
+	if (board->en_pas_square != NO_SQ)
+		board->key ^= zobrist_en_pas[file(board->en_pas_square)];
+
+	board->en_pas_square = NO_SQ;
+	board->half_move_cnt++;
+	board->turn = !board->turn;
+	board->key ^= zobrist_turn;
+}
+
+void
+undo_null_move(Board *board, Undo *undo) {
+	board->en_pas_square = undo->en_pas_square;
+	board->half_move_cnt = undo->half_move_cnt;
+	board->key           = undo->key;
+	board->turn = !board->turn;
+}
+
+/*
+ * Copy the board into the child and make the move there. Nothing has to be
+ * kept to undo the move since the parent is left as it was, which for a 192
+ * byte board is usually cheaper than working out and reversing the changes.
+ */
+void
+copy_make_move(const Board *board, Board *child, Move move) {
+	Undo undo;
+
+	*child = *board;
+	make_move(child, move, &undo);
+}
+
+/*
+ * Benchmark make/undo against copy-make by walking down an opening line and
+ * back up again, like a search going down one branch.
+ */
+
+#define BENCH_ROUNDS 200000
+#define MAX_LINE     64
+
+static const char *bench_line =
+	"e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 e1g1 f8e7 f1e1 b7b5 a4b3 d7d6 "
+	"c2c3 e8g8 h2h3 c6a5 b3c2 c7c5 d2d4 d8c7 b1d2 c5d4 c3d4 a5c6 d4d5 c6b4 "
+	"c2b1 a6a5";
+
+void
+bench_make() {
+	static Board stack[MAX_LINE + 1];
+	Move moves[MAX_LINE];
+	Undo undos[MAX_LINE];
+	int len = 0;
+
+	for (const char *str = bench_line; *str; str += str[4] ? 5 : 4)
+		moves[len++] = parse_move(str);
+
+	Board board;
+	clear_board(&board);
+	parse_fen(&board, STARTING_FEN);
+
+	struct timespec start, end;
+	Bitboard sum = 0ULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (int i = 0; i < len; i++) {
+			make_move(&board, moves[i], &undos[i]);
+			sum += board.pieces[ALL_PIECES];
+		}
+		for (int i = len - 1; i >= 0; i--)
+			undo_move(&board, moves[i], &undos[i]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double make_ns = (end.tv_sec - start.tv_sec) * 1e9 +
+		(end.tv_nsec - start.tv_nsec);
+
+	stack[0] = board;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (int i = 0; i < len; i++) {
+			copy_make_move(&stack[i], &stack[i + 1], moves[i]);
+			sum -= stack[i + 1].pieces[ALL_PIECES];
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double copy_ns = (end.tv_sec - start.tv_sec) * 1e9 +
+		(end.tv_nsec - start.tv_nsec);
+
+	printf("board     %zu bytes\n", sizeof(Board));
+	printf("make/undo %6.2f ns/move\n", make_ns / ((double)BENCH_ROUNDS * len));
+	printf("copy-make %6.2f ns/move %5.2fx %s\n",
+		copy_ns / ((double)BENCH_ROUNDS * len), make_ns / copy_ns,
+		sum ? "MISMATCH" : "");
+}
+
+/*
+ * Parse a move such as "e2e4" or "e7e8q". The move is not checked for
+ * legality.
+ */
+Move
+parse_move(const char *str) {
+	if (str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8' ||
+		str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8')
+		return NO_MOVE;
+
+	Square from = square(str[0] - 'a', str[1] - '1');
+	Square to   = square(str[2] - 'a', str[3] - '1');
+	Piece_Type promo = 0;
+
+	switch (str[4]) {
+		case 'n':
+			promo = KNIGHT;
+			break;
+		case 'b':
+			promo = BISHOP;
+			break;
+		case 'r':
+			promo = ROOK;
+			break;
+		case 'q':
+			promo = QUEEN;
+			break;
+	}
+
+	return new_move(from, to, promo);
+}
+
+/* Write a move in long algebraic notation, str needs space for 6 chars */
+void
+move_str(Move move, char *str) {
+	str[0] = 'a' + file(move_from(move));
+	str[1] = '1' + rank(move_from(move));
+	str[2] = 'a' + file(move_to(move));
+	str[3] = '1' + rank(move_to(move));
+	str[4] = " pnbrqk"[move_promo(move)];
+	str[5] = '\0';
+
+	if (!move_promo(move))
+		str[4] = '\0';
+}
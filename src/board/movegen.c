@@ -0,0 +1,202 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the move generator.
+ *
+ * Moves are pseudo legal, they follow how the pieces move but may leave the
+ * king in check. Search makes each move and then throws it away with
+ * left_in_check, which is cheaper than working out pins up front for the
+ * many moves that never get searched because of a cutoff.
+ */
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+/* Add a move from every square in from to the square that is dist away */
+static inline int
+add_pawn_moves(Move *moves, int cnt, Bitboard to, int dist, bool promo) {
+	while (to) {
+		Square sq = lsb(to);
+
+		if (promo) {
+			for (Piece_Type pt = QUEEN; pt >= KNIGHT; pt--)
+				moves[cnt++] = new_move(sq - dist, sq, pt);
+		} else {
+			moves[cnt++] = new_move(sq - dist, sq, 0);
+		}
+
+		to &= to - 1;
+	}
+
+	return cnt;
+}
+
+/*
+ * Pawn moves onto the squares in targets. Pushes and captures are asked for
+ * separately so quiescence search can get only the captures, but promotions
+ * always come along since they change the material as much as a capture.
+ */
+static int
+gen_pawn_moves(Board *board, Move *moves, int cnt, bool quiets) {
+	Turn us = board->turn;
+	Bitboard pawns = board->pieces[PAWN] & board->sides[us];
+	Bitboard empty = ~board->pieces[ALL_PIECES];
+	Bitboard enemy = board->sides[!us];
+
+	Direction up = us == WHITE ? NORTH : SOUTH;
+	Bitboard last = rank_bb(us == WHITE ? RANK_8 : RANK_1);
+	Bitboard third = rank_bb(us == WHITE ? RANK_3 : RANK_6);
+
+	if (board->en_pas_square != NO_SQ)
+		enemy |= 1ULL << board->en_pas_square;
+
+	Bitboard push = piece_shift(pawns, up) & empty;
+	Bitboard left = piece_shift(pawns, up + WEST) & enemy;
+	Bitboard right = piece_shift(pawns, up + EAST) & enemy;
+
+	cnt = add_pawn_moves(moves, cnt, push & last, up, true);
+	cnt = add_pawn_moves(moves, cnt, left & last, up + WEST, true);
+	cnt = add_pawn_moves(moves, cnt, right & last, up + EAST, true);
+	cnt = add_pawn_moves(moves, cnt, left & ~last, up + WEST, false);
+	cnt = add_pawn_moves(moves, cnt, right & ~last, up + EAST, false);
+
+	if (quiets) {
+		Bitboard dbl = piece_shift(push & third, up) & empty;
+
+		cnt = add_pawn_moves(moves, cnt, push & ~last, up, false);
+		cnt = add_pawn_moves(moves, cnt, dbl, 2 * up, false);
+	}
+
+	return cnt;
+}
+
+/* Castling, the king may not start on, pass or land on an attacked square */
+static int
+gen_castles(Board *board, Move *moves, int cnt) {
+	Turn us = board->turn;
+	Bitboard occ = board->pieces[ALL_PIECES];
+	Bitboard enemy = board->sides[!us];
+
+	Castling_Perm king_side  = us == WHITE ? CASTLE_WHITE_KING :
+	                                         CASTLE_BLACK_KING;
+	Castling_Perm queen_side = us == WHITE ? CASTLE_WHITE_QUEEN :
+	                                         CASTLE_BLACK_QUEEN;
+	Square k = us == WHITE ? E1 : E8;
+
+	if (!(board->castle_perms & (king_side | queen_side)) ||
+		(attackers_to(board, k, occ) & enemy))
+		return cnt;
+
+	if ((board->castle_perms & king_side) &&
+		!(between(k, k + 3) & occ) &&
+		!(attackers_to(board, k + 1, occ) & enemy) &&
+		!(attackers_to(board, k + 2, occ) & enemy))
+		moves[cnt++] = new_move(k, k + 2, 0);
+
+	if ((board->castle_perms & queen_side) &&
+		!(between(k, k - 4) & occ) &&
+		!(attackers_to(board, k - 1, occ) & enemy) &&
+		!(attackers_to(board, k - 2, occ) & enemy))
+		moves[cnt++] = new_move(k, k - 2, 0);
+
+	return cnt;
+}
+
+static int
+gen(Board *board, Move *moves, bool quiets) {
+	Turn us = board->turn;
+	Bitboard occ = board->pieces[ALL_PIECES];
+	Bitboard targets = board->sides[!us];
+	int cnt = 0;
+
+	if (quiets)
+		targets |= ~occ;
+
+	cnt = gen_pawn_moves(board, moves, cnt, quiets);
+
+	for (Piece_Type pt = KNIGHT; pt <= KING; pt++) {
+		Bitboard b = board->pieces[pt] & board->sides[us];
+
+		while (b) {
+			Square from = lsb(b);
+			Bitboard a;
+
+			switch (pt) {
+				case KNIGHT: a = get_knight_attacks(from);      break;
+				case BISHOP: a = get_bishop_attacks(from, occ); break;
+				case ROOK:   a = get_rook_attacks(from, occ);   break;
+				case QUEEN:  a = get_queen_attacks(from, occ);  break;
+				default:     a = get_king_attacks(from);        break;
+			}
+
+			for (a &= targets; a; a &= a - 1)
+				moves[cnt++] = new_move(from, lsb(a), 0);
+
+			b &= b - 1;
+		}
+	}
+
+	if (quiets)
+		cnt = gen_castles(board, moves, cnt);
+
+	return cnt;
+}
+
+/* Every pseudo legal move, returns how many were written */
+int
+gen_moves(Board *board, Move *moves) {
+	return gen(board, moves, true);
+}
+
+/* Captures, en passant and promotions, for quiescence search */
+int
+gen_captures(Board *board, Move *moves) {
+	return gen(board, moves, false);
+}
+
+/* After making a move, whether the side that made it is in check */
+bool
+left_in_check(Board *board) {
+	Turn moved = !board->turn;
+	Square king = lsb(board->pieces[KING] & board->sides[moved]);
+
+	return attackers_to(board, king, board->pieces[ALL_PIECES]) &
+		board->sides[board->turn];
+}
+
+/* Whether a move that isn't known to be pseudo legal is legal */
+bool
+is_legal_move(Board *board, Move move) {
+	Move moves[256];
+	int cnt = gen_moves(board, moves);
+
+	for (int i = 0; i < cnt; i++) {
+		if (moves[i] != move)
+			continue;
+
+		Undo undo;
+		make_move(board, move, &undo);
+		bool legal = !left_in_check(board);
+		undo_move(board, move, &undo);
+
+		return legal;
+	}
+
+	return false;
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the packed position format, which is meant for files
+ * of millions of positions such as training and tuning data.
+ *
+ * A record is the occupancy followed by one 4 bit piece per occupied square
+ * in square order, which works because a Piece already fits in 4 bits. Then
+ * come the turn, castling perms, en passant square, half move clock and the
+ * result of the game. At 32 bytes that is about a third of a fen.
+ *
+ * Files are mapped into memory and the records are split between threads to
+ * be decoded, since decoding is the only work there is.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+#define MAX_DECODE_THREADS 256
+
+/* Pack a board, false if it has more than the 32 pieces there is room for */
+bool
+pack_board(Board *board, uint8_t result, Packed_Board *pb) {
+	Bitboard b = board->pieces[ALL_PIECES];
+
+	if (popcnt(b) > 32)
+		return false;
+
+	*pb = (Packed_Board){ 0 };
+
+	pb->occupancy     = b;
+	pb->state         = board->turn | board->castle_perms << 1;
+	pb->en_pas_square = board->en_pas_square;
+	pb->half_move_cnt = board->half_move_cnt;
+	pb->result        = result;
+
+	for (int i = 0; b; i++) {
+		pb->pieces[i / 2] |= board->mailbox[lsb(b)] << (i % 2 * 4);
+		b &= b - 1;
+	}
+
+	return true;
+}
+
+/* Unpack into a board, false if the record isn't a valid position */
+bool
+unpack_board(const Packed_Board *pb, Board *board) {
+	Bitboard b = pb->occupancy;
+
+	/* There are only nibbles for 32 pieces */
+	if (popcnt(b) > 32)
+		return false;
+
+	clear_board(board);
+
+	for (int i = 0; b; i++) {
+		Piece p = pb->pieces[i / 2] >> (i % 2 * 4) & 15;
+
+		if (!valid_piece(p))
+			return false;
+
+		place_piece(board, p, lsb(b));
+		b &= b - 1;
+	}
+
+	board->turn          = pb->state & 1;
+	board->castle_perms  = pb->state >> 1 & 15;
+	board->en_pas_square = pb->en_pas_square;
+	board->half_move_cnt = pb->half_move_cnt;
+	board->key           = board_key(board);
+
+	return popcnt(board->pieces[KING] & board->sides[WHITE]) == 1 &&
+		popcnt(board->pieces[KING] & board->sides[BLACK]) == 1 &&
+		(board->en_pas_square == NO_SQ ||
+		 valid_square(board->en_pas_square));
+}
+
+bool
+open_packed_file(Packed_File *pf, const char *path) {
+	struct stat st;
+
+	pf->records = NULL;
+	pf->cnt = 0;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &st) || st.st_size < (off_t)sizeof(Packed_Board)) {
+		close(fd);
+		return false;
+	}
+
+	void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mem == MAP_FAILED)
+		return false;
+
+	/* Every thread reads its own part from front to back */
+	madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+	pf->records = mem;
+	pf->cnt = st.st_size / sizeof(Packed_Board);
+
+	return true;
+}
+
+void
+close_packed_file(Packed_File *pf) {
+	if (pf->records)
+		munmap((void *)pf->records, pf->cnt * sizeof(Packed_Board));
+
+	pf->records = NULL;
+	pf->cnt = 0;
+}
+
+typedef struct {
+	Packed_File *pf;
+	size_t start, end;
+	Packed_Fn f;
+	void *arg;
+	size_t decoded;
+} Decode_Job;
+
+static void *
+decode_range(void *arg) {
+	Decode_Job *job = arg;
+	Board board;
+
+	for (size_t i = job->start; i < job->end; i++) {
+		if (!unpack_board(&job->pf->records[i], &board))
+			continue;
+
+		job->f(&board, job->pf->records[i].result, i, job->arg);
+		job->decoded++;
+	}
+
+	return NULL;
+}
+
+/*
+ * Decode every record of a file, calling f with the index of each one. The
+ * records are split into one block per thread, so f is called from several
+ * threads at once and should only write to what belongs to its index.
+ * Returns the amount of valid records.
+ */
+size_t
+decode_packed_file(Packed_File *pf, int thread_cnt, Packed_Fn f, void *arg) {
+	if (thread_cnt < 1)
+		thread_cnt = 1;
+	if (thread_cnt > MAX_DECODE_THREADS)
+		thread_cnt = MAX_DECODE_THREADS;
+
+	Decode_Job jobs[thread_cnt];
+	pthread_t threads[thread_cnt];
+	bool started[thread_cnt];
+	size_t decoded = 0;
+
+	for (int i = 0; i < thread_cnt; i++) {
+		jobs[i] = (Decode_Job){
+			.pf      = pf,
+			.start   = pf->cnt * i / thread_cnt,
+			.end     = pf->cnt * (i + 1) / thread_cnt,
+			.f       = f,
+			.arg     = arg,
+			.decoded = 0,
+		};
+
+		/* Fall back to decoding on this thread if one can't be started */
+		started[i] = !pthread_create(&threads[i], NULL, decode_range, &jobs[i]);
+		if (!started[i])
+			decode_range(&jobs[i]);
+	}
+
+	for (int i = 0; i < thread_cnt; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		decoded += jobs[i].decoded;
+	}
+
+	return decoded;
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the Zobrist keys of positions, along with the cuckoo
+ * table used to spot a move that would repeat an earlier position.
+ *
+ * The cuckoo table holds the key difference of every reversible move, that
+ * is a knight, bishop, rook, queen or king of either side moving between
+ * two squares on an empty board, xored with the turn key. If the difference
+ * between the current key and an earlier one is in the table, a single move
+ * goes back to that position as long as nothing stands in the way. There are
+ * 3668 such moves, each is stored in one of two slots picked by two parts of
+ * its key, and inserting kicks out whatever is in the slot into its other
+ * slot until everything has a place.
+ */
+
+#include <assert.h>
+
+#include "defs.h"
+#include "helpers.h"
+#include "../defs.h"
+
+#define CUCKOO_SIZE 8192
+#define CUCKOO_MOVES 3668
+
+Key zobrist_pieces[PIECE_CNT][SQ_CNT];
+Key zobrist_castle[16];
+Key zobrist_en_pas[FILE_CNT];
+Key zobrist_turn;
+
+static Key cuckoo_keys[CUCKOO_SIZE];
+static Move cuckoo_moves[CUCKOO_SIZE];
+
+static inline int
+cuckoo_h1(Key key) {
+	return key & (CUCKOO_SIZE - 1);
+}
+
+static inline int
+cuckoo_h2(Key key) {
+	return (key >> 16) & (CUCKOO_SIZE - 1);
+}
+
+static Key
+zobrist_rand(uint64_t *seed) {
+	*seed ^= *seed >> 12;
+	*seed ^= *seed << 25;
+	*seed ^= *seed >> 27;
+	return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+static Bitboard
+empty_board_attacks(Piece_Type pt, Square sq) {
+	switch (pt) {
+		case KNIGHT: return get_knight_attacks(sq);
+		case BISHOP: return get_bishop_attacks(sq, 0ULL);
+		case ROOK:   return get_rook_attacks(sq, 0ULL);
+		case QUEEN:  return get_queen_attacks(sq, 0ULL);
+		default:     return get_king_attacks(sq);
+	}
+}
+
+static void
+init_cuckoo() {
+	int cnt = 0;
+
+	for (Turn t = WHITE; t <= BLACK; t++)
+		for (Piece_Type pt = KNIGHT; pt <= KING; pt++)
+			for (Square a = A1; a <= H8; a++)
+				for (Square b = a + 1; b <= H8; b++) {
+					if (!(empty_board_attacks(pt, a) & 1ULL << b))
+						continue;
+
+					Piece p = make_piece(pt, t);
+					Move move = new_move(a, b, 0);
+					Key key = zobrist_pieces[p][a] ^ zobrist_pieces[p][b] ^
+						zobrist_turn;
+
+					int i = cuckoo_h1(key);
+					for (;;) {
+						Key k = cuckoo_keys[i];
+						Move m = cuckoo_moves[i];
+
+						cuckoo_keys[i] = key;
+						cuckoo_moves[i] = move;
+
+						if (!m)
+							break;
+
+						/* Move the one that was there to its other slot */
+						key = k;
+						move = m;
+						i = i == cuckoo_h1(key) ? cuckoo_h2(key) :
+						                          cuckoo_h1(key);
+					}
+
+					cnt++;
+				}
+
+	assert(cnt == CUCKOO_MOVES);
+	(void)cnt;
+}
+
+/* Called from init_attacks, since the cuckoo table needs the attacks */
+void
+init_zobrist() {
+	uint64_t seed = 0x3243F6A8885A308DULL;
+
+	for (Piece p = NO_PIECE; p < PIECE_CNT; p++)
+		for (Square sq = A1; sq <= H8; sq++)
+			zobrist_pieces[p][sq] = valid_piece(p) ? zobrist_rand(&seed) : 0;
+
+	/* Each castling right gets a key and combinations are xored together */
+	Key rights[4];
+	for (int i = 0; i < 4; i++)
+		rights[i] = zobrist_rand(&seed);
+
+	for (int perms = 0; perms < 16; perms++) {
+		zobrist_castle[perms] = 0ULL;
+		for (int i = 0; i < 4; i++)
+			if (perms & 1 << i)
+				zobrist_castle[perms] ^= rights[i];
+	}
+
+	for (File f = FILE_A; f <= FILE_H; f++)
+		zobrist_en_pas[f] = zobrist_rand(&seed);
+
+	zobrist_turn = zobrist_rand(&seed);
+
+	init_cuckoo();
+}
+
+/* Work out the key of a position from scratch */
+Key
+board_key(Board *board) {
+	Key key = zobrist_castle[board->castle_perms];
+
+	for (Square sq = A1; sq <= H8; sq++)
+		key ^= zobrist_pieces[board->mailbox[sq]][sq];
+
+	if (board->en_pas_square != NO_SQ)
+		key ^= zobrist_en_pas[file(board->en_pas_square)];
+
+	if (board->turn == BLACK)
+		key ^= zobrist_turn;
+
+	return key;
+}
+
+/* Find the reversible move with this key difference, or NO_MOVE */
+Move
+cuckoo_move(Key diff) {
+	int i = cuckoo_h1(diff);
+
+	if (cuckoo_keys[i] == diff)
+		return cuckoo_moves[i];
+
+	i = cuckoo_h2(diff);
+
+	if (cuckoo_keys[i] == diff)
+		return cuckoo_moves[i];
+
+	return NO_MOVE;
+}
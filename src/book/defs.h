@@ -0,0 +1,36 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "../defs.h"
+#include "../board/defs.h"
+
+#define BOOK_FILE_LEN 1024
+
+/* UCI options */
+extern bool own_book;
+extern bool book_best_move;
+extern char book_file[BOOK_FILE_LEN];
+
+void init_book();
+bool book_keys_valid();
+bool open_book(const char *path);
+void close_book();
+uint64_t polyglot_key(Board *board);
+Move probe_book(Board *board);
@@ -18,11 +18,15 @@
 
 #include <stdint.h>
 
+#define CACHE_LINE_SIZE 64
+
 typedef uint64_t Bitboard;
 typedef uint8_t Castling_Perm;
 typedef int8_t Shift;
 
 typedef enum {
+	/* Only used to index the occupancy in Board.pieces */
+	ALL_PIECES,
 	PAWN=1, KNIGHT, BISHOP, ROOK, QUEEN, KING,
 	PIECE_TYPE_CNT
 } Piece_Type;
@@ -0,0 +1,104 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the eval cache and the eval correction table.
+ *
+ * The cache keeps the static eval of positions by their Zobrist key, so
+ * transpositions and positions searched again at the next depth aren't
+ * evaluated twice.
+ *
+ * The correction table learns from search. Whenever search ends up with a
+ * score that is far from the static eval, the difference is added to the
+ * entry for the pawn structure and material of the position, as a running
+ * average. Static evals are then moved by that much, which fixes things the
+ * eval gets wrong about a whole class of positions. Corrections change all
+ * the time, so the cache stores the raw eval and they are added afterwards.
+ */
+
+#include <string.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+void
+clear_eval_cache(Eval_Cache *ec) {
+	memset(ec, 0, sizeof(*ec));
+}
+
+/* Get the static eval of a position, from the cache if it is there */
+Value
+raw_eval(Board *board, Eval_Cache *ec) {
+	Eval_Entry *e = &ec->entries[board->key & (EVAL_CACHE_SIZE - 1)];
+	uint32_t check = board->key >> 32;
+
+	ec->probes++;
+
+	if (e->check == check) {
+		ec->hits++;
+		return e->value;
+	}
+
+	e->check = check;
+	e->value = evaluate(board);
+
+	return e->value;
+}
+
+static inline int16_t *
+correction_entry(Board *board, Eval_Cache *ec) {
+	Key key = material_key(board) * 0x9E3779B97F4A7C15ULL;
+	Bitboard pawns = board->pieces[PAWN];
+
+	while (pawns) {
+		Square sq = lsb(pawns);
+		key ^= zobrist_pieces[board->mailbox[sq]][sq];
+		pawns &= pawns - 1;
+	}
+
+	return &ec->correction[board->turn][key & (CORRECTION_SIZE - 1)];
+}
+
+/* Move a static eval by what search has learned about similar positions */
+Value
+correct_eval(Board *board, Eval_Cache *ec, Value v) {
+	/* Known results from the endgame code are exact already */
+	if (v >= VALUE_KNOWN_WIN || v <= -VALUE_KNOWN_WIN)
+		return v;
+
+	return v + *correction_entry(board, ec) / CORRECTION_GRAIN;
+}
+
+/*
+ * Add the difference between a search score and the raw static eval of a
+ * position. Deeper searches are trusted more.
+ */
+void
+update_correction(Board *board, Eval_Cache *ec, int depth, Value diff) {
+	int16_t *entry = correction_entry(board, ec);
+	int weight = depth + 1 < 16 ? depth + 1 : 16;
+	int c = (*entry * (256 - weight) + diff * CORRECTION_GRAIN * weight) / 256;
+
+	*entry = c >  CORRECTION_MAX ?  CORRECTION_MAX :
+	         c < -CORRECTION_MAX ? -CORRECTION_MAX : c;
+}
+
+/* Fraction of lookups that were hits, for sizing the cache */
+double
+eval_cache_hit_rate(Eval_Cache *ec) {
+	return ec->probes ? (double)ec->hits / ec->probes : 0.0;
+}
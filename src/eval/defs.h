@@ -0,0 +1,109 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "../defs.h"
+#include "../board/defs.h"
+
+/* Scores are in centipawns from the point of view of the side to move */
+typedef int Value;
+
+enum {
+	VALUE_DRAW      = 0,
+	VALUE_KNOWN_WIN = 10000,
+
+	PAWN_VALUE   = 100,
+	KNIGHT_VALUE = 320,
+	BISHOP_VALUE = 330,
+	ROOK_VALUE   = 500,
+	QUEEN_VALUE  = 900,
+};
+
+/*
+ * Scale factors are applied to the score of the side that is ahead, a factor
+ * of SCALE_NORMAL leaves it as it is and SCALE_DRAW turns it into a draw.
+ */
+typedef uint8_t Scale;
+
+enum {
+	SCALE_DRAW   = 0,
+	SCALE_NORMAL = 64,
+};
+
+/*
+ * Weights are tapered between the middlegame and the endgame by the amount
+ * of non pawn material left, a knight or bishop counts 1, a rook 2 and a
+ * queen 4 for a total of PHASE_MAX.
+ */
+typedef enum {
+	MG, EG,
+	PHASE_CNT
+} Phase;
+
+#define PHASE_MAX 24
+
+/* The material key of a position, see material_key in "eval/endgame.c" */
+typedef uint64_t Material_Key;
+
+/*
+ * Every search thread has its own eval cache, so entries are written without
+ * any locking. Sizes are in entries and have to be powers of two.
+ */
+#define EVAL_CACHE_SIZE (1 << 16)
+#define CORRECTION_SIZE (1 << 14)
+
+/* Corrections are stored in 1/CORRECTION_GRAIN of a centipawn */
+#define CORRECTION_GRAIN 256
+#define CORRECTION_MAX   (64 * CORRECTION_GRAIN)
+
+typedef struct {
+	/* The top half of the key, the bottom half picks the entry */
+	uint32_t check;
+	Value value;
+} Eval_Entry;
+
+typedef struct {
+	Eval_Entry entries[EVAL_CACHE_SIZE];
+
+	/*
+	 * How far off the static eval has been from search results, for each
+	 * side to move, indexed by the pawns and the material
+	 */
+	int16_t correction[TURN_CNT][CORRECTION_SIZE];
+
+	uint64_t probes;
+	uint64_t hits;
+} Eval_Cache;
+
+Value evaluate(Board *board);
+uint8_t game_phase(Board *board);
+
+void clear_eval_cache(Eval_Cache *ec);
+Value raw_eval(Board *board, Eval_Cache *ec);
+Value correct_eval(Board *board, Eval_Cache *ec, Value v);
+void update_correction(Board *board, Eval_Cache *ec, int depth, Value diff);
+double eval_cache_hit_rate(Eval_Cache *ec);
+
+void init_kpk();
+bool probe_kpk(Square wk, Square wp, Square bk, Turn t);
+
+void init_endgames();
+Material_Key material_key(Board *board);
+bool endgame_value(Board *board, Value *v);
+Scale endgame_scale(Board *board, Turn strong);
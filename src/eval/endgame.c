@@ -0,0 +1,340 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains specialized evaluation and scaling functions for simple
+ * endgames where the normal evaluation has no idea what is going on, so
+ * search would have to find the result the slow way.
+ *
+ * The functions that only work for an exact set of material are found with
+ * a small hash table keyed by the material key of the position. Scaling
+ * functions that don't care about the amount of pawns are checked by piece
+ * counts instead.
+ */
+
+#include <string.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+#define ENDGAME_TABLE_SIZE 64
+
+#define LIGHT_SQUARES 0x55AA55AA55AA55AAULL
+
+typedef Value (*Endgame_Func)(Board *board, Turn strong);
+
+typedef struct {
+	Material_Key key;
+	Turn strong;
+	Endgame_Func func;
+} Endgame;
+
+static Endgame endgame_table[ENDGAME_TABLE_SIZE];
+
+/* Helpers */
+
+static inline uint8_t
+piece_cnt(Board *board, Piece_Type pt, Turn t) {
+	return popcnt(board->pieces[pt] & board->sides[t]);
+}
+
+static inline Square
+king_square(Board *board, Turn t) {
+	return lsb(board->pieces[KING] & board->sides[t]);
+}
+
+/* Flip a square so the strong side always looks like it is white */
+static inline Square
+relative_square(Square sq, Turn strong) {
+	return strong == WHITE ? sq : sq ^ 56;
+}
+
+static inline bool
+light_square(Square sq) {
+	return LIGHT_SQUARES & 1ULL << sq;
+}
+
+/* Higher when the square is closer to the edge of the board */
+static inline Value
+push_to_edge(Square sq) {
+	int f = file(sq) < FILE_E ? file(sq) : FILE_H - file(sq);
+	int r = rank(sq) < RANK_5 ? rank(sq) : RANK_8 - rank(sq);
+	return 90 - 20 * (f < r ? f : r) - 10 * (f + r);
+}
+
+static inline Value
+push_close(Square a, Square b) {
+	return 140 - 20 * distance(a, b);
+}
+
+/* Turn a score for the strong side into one for the side to move */
+static inline Value
+to_move(Board *board, Turn strong, Value v) {
+	return board->turn == strong ? v : -v;
+}
+
+/* Evaluation functions */
+
+static Value
+eval_draw(Board *board, Turn strong) {
+	(void)board;
+	(void)strong;
+	return VALUE_DRAW;
+}
+
+/* KPK, look it up in the bitbase */
+static Value
+eval_kpk(Board *board, Turn strong) {
+	Turn weak = !strong;
+
+	Square wk = relative_square(king_square(board, strong), strong);
+	Square bk = relative_square(king_square(board, weak), strong);
+	Square wp = relative_square(lsb(board->pieces[PAWN]), strong);
+	Turn t = board->turn == strong ? WHITE : BLACK;
+
+	if (!probe_kpk(wk, wp, bk, t))
+		return VALUE_DRAW;
+
+	return to_move(board, strong,
+		VALUE_KNOWN_WIN + PAWN_VALUE + 10 * rank(wp));
+}
+
+/* KRK and KQK, drive the king to the edge and bring our own king closer */
+static Value
+eval_kxk(Board *board, Turn strong) {
+	Square wk = king_square(board, strong);
+	Square bk = king_square(board, !strong);
+
+	Value v = VALUE_KNOWN_WIN + push_to_edge(bk) + push_close(wk, bk) +
+		(board->pieces[QUEEN] ? QUEEN_VALUE : ROOK_VALUE);
+
+	return to_move(board, strong, v);
+}
+
+/*
+ * KBNK, mate can only be forced in a corner of the same colour as the
+ * bishop, so drive the king towards the closest of those.
+ */
+static Value
+eval_kbnk(Board *board, Turn strong) {
+	Square wk = king_square(board, strong);
+	Square bk = king_square(board, !strong);
+
+	/* A1 and H8 are dark, for a light bishop flip onto A8 and H1 instead */
+	Square csq = light_square(lsb(board->pieces[BISHOP])) ? bk ^ 56 : bk;
+
+	int corner = distance(csq, A1) < distance(csq, H8) ?
+		distance(csq, A1) : distance(csq, H8);
+
+	Value v = VALUE_KNOWN_WIN + BISHOP_VALUE + KNIGHT_VALUE +
+		push_close(wk, bk) + 50 * (7 - corner);
+
+	return to_move(board, strong, v);
+}
+
+/*
+ * KRKP, usually a win unless the pawn is far advanced and supported by its
+ * king while ours is far away.
+ */
+static Value
+eval_krkp(Board *board, Turn strong) {
+	Turn weak = !strong;
+
+	Square wk = relative_square(king_square(board, strong), strong);
+	Square bk = relative_square(king_square(board, weak), strong);
+	Square rsq = relative_square(lsb(board->pieces[ROOK]), strong);
+	Square psq = relative_square(lsb(board->pieces[PAWN]), strong);
+
+	Square promo = square(file(psq), RANK_1);
+	bool weak_to_move = board->turn == weak;
+
+	Value v;
+
+	/* Our king is in front of the pawn */
+	if (file(wk) == file(psq) && rank(wk) < rank(psq))
+		v = ROOK_VALUE - distance(wk, psq);
+
+	/* Their king is too far from both the pawn and the rook */
+	else if (distance(bk, psq) >= 3 + weak_to_move && distance(bk, rsq) >= 3)
+		v = ROOK_VALUE - distance(wk, psq);
+
+	/* The pawn is close to promoting, supported and our king is far away */
+	else if (rank(bk) <= RANK_3 && distance(bk, psq) == 1 &&
+		rank(wk) >= RANK_4 && distance(wk, psq) > 2 + !weak_to_move)
+		v = 80 - 8 * distance(wk, psq);
+
+	else
+		v = 200 - 8 * (distance(wk, psq + SOUTH) -
+			distance(bk, psq + SOUTH) - distance(psq, promo));
+
+	return to_move(board, strong, v);
+}
+
+/*
+ * The material key packs the amount of each piece type into 4 bits, so two
+ * positions have the same key exactly when they have the same material.
+ */
+Material_Key
+material_key(Board *board) {
+	Material_Key key = 0;
+
+	for (Turn t = WHITE; t <= BLACK; t++)
+		for (Piece_Type pt = PAWN; pt <= QUEEN; pt++)
+			key |= (Material_Key)piece_cnt(board, pt, t) <<
+				(4 * (t * 5 + pt - 1));
+
+	return key;
+}
+
+/* Material key for a code such as "KBNK" with strong being the first king */
+static Material_Key
+code_key(const char *code, Turn strong) {
+	Material_Key key = 0;
+	Turn t = !strong;
+
+	for (; *code; code++) {
+		const char *pt = strchr(" PNBRQ", *code);
+
+		if (*code == 'K')
+			t = !t;
+		else if (pt)
+			key += 1ULL << (4 * (t * 5 + (pt - " PNBRQ") - 1));
+	}
+
+	return key;
+}
+
+static inline uint8_t
+endgame_slot(Material_Key key) {
+	return (key * 0x9E3779B97F4A7C15ULL) >> 58;
+}
+
+static void
+add_endgame(const char *code, Endgame_Func func) {
+	for (Turn strong = WHITE; strong <= BLACK; strong++) {
+		Material_Key key = code_key(code, strong);
+		uint8_t slot = endgame_slot(key);
+
+		while (endgame_table[slot].func)
+			slot = (slot + 1) % ENDGAME_TABLE_SIZE;
+
+		endgame_table[slot] = (Endgame){ key, strong, func };
+	}
+}
+
+/* Has to be called after init_attacks */
+void
+init_endgames() {
+	init_kpk();
+
+	memset(endgame_table, 0, sizeof(endgame_table));
+
+	add_endgame("KK",   eval_draw);
+	add_endgame("KNK",  eval_draw);
+	add_endgame("KBK",  eval_draw);
+	add_endgame("KNNK", eval_draw);
+
+	add_endgame("KPK",  eval_kpk);
+	add_endgame("KRK",  eval_kxk);
+	add_endgame("KQK",  eval_kxk);
+	add_endgame("KBNK", eval_kbnk);
+	add_endgame("KRKP", eval_krkp);
+}
+
+/*
+ * If there is an evaluation function for the material in this position,
+ * write its score into v and return true.
+ */
+bool
+endgame_value(Board *board, Value *v) {
+	Material_Key key = material_key(board);
+	uint8_t slot = endgame_slot(key);
+
+	for (; endgame_table[slot].func; slot = (slot + 1) % ENDGAME_TABLE_SIZE) {
+		if (endgame_table[slot].key == key) {
+			*v = endgame_table[slot].func(board, endgame_table[slot].strong);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Scaling functions */
+
+/*
+ * A bishop and pawns that are all on a rook file can't win if the bishop
+ * doesn't control the promotion square and the other king gets there.
+ */
+static bool
+wrong_bishop(Board *board, Turn strong) {
+	Bitboard pawns = board->pieces[PAWN] & board->sides[strong];
+
+	/* All of the pawns have to be on the same rook file */
+	if (!pawns || ((pawns & ~file_bb(FILE_A)) && (pawns & ~file_bb(FILE_H))))
+		return false;
+
+	Square promo = relative_square(
+		square(file(lsb(pawns)), RANK_8), strong);
+
+	if (light_square(lsb(board->pieces[BISHOP] & board->sides[strong])) ==
+		light_square(promo))
+		return false;
+
+	return distance(king_square(board, !strong), promo) <= 1;
+}
+
+/*
+ * Get the factor that the score of the strong side should be scaled by when
+ * it is the one that is ahead.
+ */
+Scale
+endgame_scale(Board *board, Turn strong) {
+	assert(valid_turn(strong));
+
+	Turn weak = !strong;
+
+	Bitboard knights = board->pieces[KNIGHT];
+	Bitboard bishops = board->pieces[BISHOP];
+	Bitboard majors  = board->pieces[ROOK] | board->pieces[QUEEN];
+
+	uint8_t strong_pawns = piece_cnt(board, PAWN, strong);
+	uint8_t weak_pawns   = piece_cnt(board, PAWN, weak);
+
+	if (knights || majors)
+		return SCALE_NORMAL;
+
+	/* KB and pawns against a king, maybe with pawns */
+	if (piece_cnt(board, BISHOP, strong) == 1 && !(bishops & board->sides[weak])
+		&& wrong_bishop(board, strong))
+		return SCALE_DRAW;
+
+	/* Bishops of opposite colours with nothing else but pawns */
+	if (piece_cnt(board, BISHOP, strong) == 1 &&
+		piece_cnt(board, BISHOP, weak) == 1 &&
+		light_square(lsb(bishops & board->sides[strong])) !=
+		light_square(lsb(bishops & board->sides[weak]))) {
+
+		/* A single extra pawn is almost always a draw */
+		if (strong_pawns - weak_pawns <= 1)
+			return 8;
+
+		return SCALE_NORMAL / 2 + 4 * (strong_pawns - weak_pawns);
+	}
+
+	return SCALE_NORMAL;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the static evaluation, which for now is just material
+ * and piece square tables tapered by the game phase. It is meant to be
+ * replaced by NNUE later on.
+ */
+
+#include "defs.h"
+#include "psqt.h"
+#include "../board/helpers.h"
+
+static const uint8_t phase_weights[PIECE_TYPE_CNT] = { 0, 0, 1, 1, 2, 4, 0 };
+
+uint8_t
+game_phase(Board *board) {
+	uint8_t phase = 0;
+
+	for (Piece_Type pt = KNIGHT; pt <= QUEEN; pt++)
+		phase += phase_weights[pt] * popcnt(board->pieces[pt]);
+
+	/* Extra material from promotions shouldn't go over the max */
+	return phase < PHASE_MAX ? phase : PHASE_MAX;
+}
+
+Value
+evaluate(Board *board) {
+	Value v;
+
+	if (endgame_value(board, &v))
+		return v;
+
+	Value score[PHASE_CNT] = { 0, 0 };
+
+	for (Turn t = WHITE; t <= BLACK; t++) {
+		int sign = t == WHITE ? 1 : -1;
+
+		for (Piece_Type pt = PAWN; pt <= KING; pt++) {
+			Bitboard b = board->pieces[pt] & board->sides[t];
+
+			while (b) {
+				/* The tables are for white, so flip the square for black */
+				Square sq = t == WHITE ? lsb(b) : lsb(b) ^ 56;
+
+				for (Phase ph = MG; ph <= EG; ph++)
+					score[ph] += sign *
+						(piece_values[ph][pt] + psqt[ph][pt][sq]);
+
+				b &= b - 1;
+			}
+		}
+	}
+
+	uint8_t phase = game_phase(board);
+
+	v = (score[MG] * phase + score[EG] * (PHASE_MAX - phase)) / PHASE_MAX;
+
+	/* Scale down endgames that are hard to win for the side that is ahead */
+	v = v * endgame_scale(board, v > 0 ? WHITE : BLACK) / SCALE_NORMAL;
+
+	return board->turn == WHITE ? v : -v;
+}
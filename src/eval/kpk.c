@@ -0,0 +1,187 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the king and pawn versus king bitbase.
+ *
+ * Every position with white having the pawn on files A to D is solved at
+ * startup by retrograde analysis, then only one bit per position is kept
+ * which says whether white wins. Positions with the pawn on files E to H are
+ * mirrored, and positions where black has the pawn are flipped.
+ *
+ * That is 2 sides * 24 pawn squares * 64 * 64 king squares = 196608 bits,
+ * 24KB in total.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+#define KPK_SIZE (2 * 24 * 64 * 64)
+
+enum {
+	INVALID = 0,
+	UNKNOWN = 1 << 0,
+	DRAW    = 1 << 1,
+	WIN     = 1 << 2,
+};
+
+static uint32_t kpk_bitbase[KPK_SIZE / 32];
+
+/*
+ * Bit 0 is the side to move, bits 1-6 the black king, bits 7-12 the white
+ * king, bits 13-14 the pawn file and bits 15-17 how far the pawn is from the
+ * 7th rank.
+ */
+static inline uint32_t
+kpk_index(Turn t, Square bk, Square wk, Square wp) {
+	return t | bk << 1 | wk << 7 | file(wp) << 13 | (RANK_7 - rank(wp)) << 15;
+}
+
+/* Classify a position without looking at any moves */
+static uint8_t
+kpk_init(uint32_t idx) {
+	Turn t    = idx & 1;
+	Square bk = (idx >> 1) & 63;
+	Square wk = (idx >> 7) & 63;
+	Square wp = square((idx >> 13) & 3, RANK_7 - (idx >> 15));
+
+	if (wk == bk || wk == wp || bk == wp || distance(wk, bk) <= 1)
+		return INVALID;
+
+	/* Black can't be in check when it is white to move */
+	if (t == WHITE && (get_pawn_attacks(wp, WHITE) & 1ULL << bk))
+		return INVALID;
+
+	if (t == WHITE) {
+		/* The pawn can promote without the queen being taken */
+		Square promo = wp + NORTH;
+
+		if (rank(wp) == RANK_7 && wk != promo && bk != promo &&
+			(distance(bk, promo) > 1 || distance(wk, promo) == 1))
+			return WIN;
+
+	} else {
+		Bitboard moves = get_king_attacks(bk) &
+			~(get_king_attacks(wk) | get_pawn_attacks(wp, WHITE));
+
+		/* Stalemate */
+		if (!moves && !(get_pawn_attacks(wp, WHITE) & 1ULL << bk))
+			return DRAW;
+
+		/* The pawn is undefended and can be taken */
+		if (moves & 1ULL << wp)
+			return DRAW;
+	}
+
+	return UNKNOWN;
+}
+
+/* Work out a position from the results of the positions after each move */
+static uint8_t
+kpk_classify(uint8_t *db, uint32_t idx) {
+	Turn t    = idx & 1;
+	Square bk = (idx >> 1) & 63;
+	Square wk = (idx >> 7) & 63;
+	Square wp = square((idx >> 13) & 3, RANK_7 - (idx >> 15));
+
+	uint8_t r = INVALID;
+	Bitboard moves;
+
+	if (t == WHITE) {
+		moves = get_king_attacks(wk) & ~get_king_attacks(bk) & ~(1ULL << wp);
+		while (moves) {
+			r |= db[kpk_index(BLACK, bk, lsb(moves), wp)];
+			moves &= moves - 1;
+		}
+
+		/* Promotions were already handled in kpk_init */
+		Square push = wp + NORTH;
+		if (rank(wp) < RANK_7 && push != wk && push != bk) {
+			r |= db[kpk_index(BLACK, bk, wk, push)];
+
+			if (rank(wp) == RANK_2 && push + NORTH != wk && push + NORTH != bk)
+				r |= db[kpk_index(BLACK, bk, wk, push + NORTH)];
+		}
+
+		return r & WIN ? WIN : r & UNKNOWN ? UNKNOWN : DRAW;
+	}
+
+	moves = get_king_attacks(bk) & ~get_king_attacks(wk) &
+		~get_pawn_attacks(wp, WHITE) & ~(1ULL << wp);
+	while (moves) {
+		r |= db[kpk_index(WHITE, lsb(moves), wk, wp)];
+		moves &= moves - 1;
+	}
+
+	/* No moves left here means checkmate, stalemate was handled already */
+	return r & DRAW ? DRAW : r & UNKNOWN ? UNKNOWN : WIN;
+}
+
+/* Has to be called after init_attacks */
+void
+init_kpk() {
+	uint8_t *db = malloc(KPK_SIZE);
+	bool changed;
+
+	for (uint32_t idx = 0; idx < KPK_SIZE; idx++)
+		db[idx] = kpk_init(idx);
+
+	/* Keep going until nothing new can be worked out */
+	do {
+		changed = false;
+
+		for (uint32_t idx = 0; idx < KPK_SIZE; idx++) {
+			if (db[idx] != UNKNOWN)
+				continue;
+
+			db[idx] = kpk_classify(db, idx);
+			changed |= db[idx] != UNKNOWN;
+		}
+	} while (changed);
+
+	/* Whatever is left can't be won */
+	memset(kpk_bitbase, 0, sizeof(kpk_bitbase));
+	for (uint32_t idx = 0; idx < KPK_SIZE; idx++)
+		if (db[idx] == WIN)
+			kpk_bitbase[idx / 32] |= 1U << (idx % 32);
+
+	free(db);
+}
+
+/*
+ * Check whether white wins with its king on wk and pawn on wp against the
+ * black king on bk, with t to move.
+ */
+bool
+probe_kpk(Square wk, Square wp, Square bk, Turn t) {
+	assert(valid_square(wk) && valid_square(wp) && valid_square(bk));
+	assert(rank(wp) >= RANK_2 && rank(wp) <= RANK_7);
+
+	/* Mirror the pawn onto files A to D */
+	if (file(wp) > FILE_D) {
+		wk ^= 7;
+		wp ^= 7;
+		bk ^= 7;
+	}
+
+	uint32_t idx = kpk_index(t, bk, wk, wp);
+
+	return kpk_bitbase[idx / 32] & 1U << (idx % 32);
+}
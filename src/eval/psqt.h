@@ -0,0 +1,190 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Evaluation weights, this file is written by the tuner in "tune/tune.c".
+ * The square tables are from white's point of view starting at A1.
+ */
+#pragma once
+
+#include "defs.h"
+
+static const Value piece_values[PHASE_CNT][PIECE_TYPE_CNT] = {
+	{ 0, 82, 337, 365, 477, 1025, 0 },
+	{ 0, 94, 281, 297, 512, 936, 0 },
+};
+
+static const Value psqt[PHASE_CNT][PIECE_TYPE_CNT][SQ_CNT] = {
+	{
+		/* No piece */
+		{
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+		},
+		/* Pawn */
+		{
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   4,    4,    4,    4,    4,    4,    4,    4,
+			   8,    8,    8,   16,   16,    8,    8,    8,
+			  12,   12,   12,   20,   20,   12,   12,   12,
+			  16,   16,   16,   16,   16,   16,   16,   16,
+			  20,   20,   20,   20,   20,   20,   20,   20,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+		},
+		/* Knight */
+		{
+			 -36,  -36,  -36,  -36,  -36,  -36,  -36,  -36,
+			 -36,  -24,  -24,  -24,  -24,  -24,  -24,  -36,
+			 -36,  -24,  -12,  -12,  -12,  -12,  -24,  -36,
+			 -36,  -24,  -12,    0,    0,  -12,  -24,  -36,
+			 -36,  -24,  -12,    0,    0,  -12,  -24,  -36,
+			 -36,  -24,  -12,  -12,  -12,  -12,  -24,  -36,
+			 -36,  -24,  -24,  -24,  -24,  -24,  -24,  -36,
+			 -36,  -36,  -36,  -36,  -36,  -36,  -36,  -36,
+		},
+		/* Bishop */
+		{
+			 -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,
+			 -15,  -10,  -10,  -10,  -10,  -10,  -10,  -15,
+			 -15,  -10,   -5,   -5,   -5,   -5,  -10,  -15,
+			 -15,  -10,   -5,    0,    0,   -5,  -10,  -15,
+			 -15,  -10,   -5,    0,    0,   -5,  -10,  -15,
+			 -15,  -10,   -5,   -5,   -5,   -5,  -10,  -15,
+			 -15,  -10,  -10,  -10,  -10,  -10,  -10,  -15,
+			 -15,  -15,  -15,  -15,  -15,  -15,  -15,  -15,
+		},
+		/* Rook */
+		{
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			  15,   15,   15,   15,   15,   15,   15,   15,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+		},
+		/* Queen */
+		{
+			  -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,
+			  -9,   -6,   -6,   -6,   -6,   -6,   -6,   -9,
+			  -9,   -6,   -3,   -3,   -3,   -3,   -6,   -9,
+			  -9,   -6,   -3,    0,    0,   -3,   -6,   -9,
+			  -9,   -6,   -3,    0,    0,   -3,   -6,   -9,
+			  -9,   -6,   -3,   -3,   -3,   -3,   -6,   -9,
+			  -9,   -6,   -6,   -6,   -6,   -6,   -6,   -9,
+			  -9,   -9,   -9,   -9,   -9,   -9,   -9,   -9,
+		},
+		/* King */
+		{
+			   0,   20,   20,    0,    0,    0,   20,    0,
+			 -10,  -10,  -10,  -10,  -10,  -10,  -10,  -10,
+			 -20,  -20,  -20,  -20,  -20,  -20,  -20,  -20,
+			 -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
+			 -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
+			 -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
+			 -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
+			 -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
+		},
+	},
+	{
+		/* No piece */
+		{
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+		},
+		/* Pawn */
+		{
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+			  12,   12,   12,   12,   12,   12,   12,   12,
+			  24,   24,   24,   24,   24,   24,   24,   24,
+			  36,   36,   36,   36,   36,   36,   36,   36,
+			  48,   48,   48,   48,   48,   48,   48,   48,
+			  60,   60,   60,   60,   60,   60,   60,   60,
+			   0,    0,    0,    0,    0,    0,    0,    0,
+		},
+		/* Knight */
+		{
+			 -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
+			 -30,  -20,  -20,  -20,  -20,  -20,  -20,  -30,
+			 -30,  -20,  -10,  -10,  -10,  -10,  -20,  -30,
+			 -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+			 -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+			 -30,  -20,  -10,  -10,  -10,  -10,  -20,  -30,
+			 -30,  -20,  -20,  -20,  -20,  -20,  -20,  -30,
+			 -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
+		},
+		/* Bishop */
+		{
+			 -18,  -18,  -18,  -18,  -18,  -18,  -18,  -18,
+			 -18,  -12,  -12,  -12,  -12,  -12,  -12,  -18,
+			 -18,  -12,   -6,   -6,   -6,   -6,  -12,  -18,
+			 -18,  -12,   -6,    0,    0,   -6,  -12,  -18,
+			 -18,  -12,   -6,    0,    0,   -6,  -12,  -18,
+			 -18,  -12,   -6,   -6,   -6,   -6,  -12,  -18,
+			 -18,  -12,  -12,  -12,  -12,  -12,  -12,  -18,
+			 -18,  -18,  -18,  -18,  -18,  -18,  -18,  -18,
+		},
+		/* Rook */
+		{
+			  -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,
+			  -6,   -4,   -4,   -4,   -4,   -4,   -4,   -6,
+			  -6,   -4,   -2,   -2,   -2,   -2,   -4,   -6,
+			  -6,   -4,   -2,    0,    0,   -2,   -4,   -6,
+			  -6,   -4,   -2,    0,    0,   -2,   -4,   -6,
+			  -6,   -4,   -2,   -2,   -2,   -2,   -4,   -6,
+			  -6,   -4,   -4,   -4,   -4,   -4,   -4,   -6,
+			  -6,   -6,   -6,   -6,   -6,   -6,   -6,   -6,
+		},
+		/* Queen */
+		{
+			 -18,  -18,  -18,  -18,  -18,  -18,  -18,  -18,
+			 -18,  -12,  -12,  -12,  -12,  -12,  -12,  -18,
+			 -18,  -12,   -6,   -6,   -6,   -6,  -12,  -18,
+			 -18,  -12,   -6,    0,    0,   -6,  -12,  -18,
+			 -18,  -12,   -6,    0,    0,   -6,  -12,  -18,
+			 -18,  -12,   -6,   -6,   -6,   -6,  -12,  -18,
+			 -18,  -12,  -12,  -12,  -12,  -12,  -12,  -18,
+			 -18,  -18,  -18,  -18,  -18,  -18,  -18,  -18,
+		},
+		/* King */
+		{
+			 -36,  -36,  -36,  -36,  -36,  -36,  -36,  -36,
+			 -36,  -24,  -24,  -24,  -24,  -24,  -24,  -36,
+			 -36,  -24,  -12,  -12,  -12,  -12,  -24,  -36,
+			 -36,  -24,  -12,    0,    0,  -12,  -24,  -36,
+			 -36,  -24,  -12,    0,    0,  -12,  -24,  -36,
+			 -36,  -24,  -12,  -12,  -12,  -12,  -24,  -36,
+			 -36,  -24,  -24,  -24,  -24,  -24,  -24,  -36,
+			 -36,  -36,  -36,  -36,  -36,  -36,  -36,  -36,
+		},
+	},
+};
@@ -25,9 +25,17 @@
 
 #include "board/defs.h"
 #include "board/helpers.h"
+#include "book/defs.h"
+#include "eval/defs.h"
+#include "match/defs.h"
+#include "search/defs.h"
+#include "search/helpers.h"
+#include "thread/defs.h"
+#include "tune/defs.h"
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 const char version_str[] = "0.1";
@@ -43,11 +51,20 @@ void
 print_uci_info() {
 	printf("id name Nerd Engine %s\n", version_str);
 	printf("id author Benjamin Paul\n");
+	printf("option name NUMA Binding type check default %s\n",
+		numa_binding ? "true" : "false");
+	printf("option name OwnBook type check default %s\n",
+		own_book ? "true" : "false");
+	printf("option name BookFile type string default %s\n", book_file);
+	printf("option name BookBestMove type check default %s\n",
+		book_best_move ? "true" : "false");
+	print_search_options();
 	printf("uciok\n");
 }
 
-void parse_position(Board *board, char *str) {
+void parse_position(Board *board, Key_History *kh, char *str) {
 	clear_board(board);
+	clear_key_history(kh);
 
 	str += 9;
 
@@ -55,12 +72,129 @@ void parse_position(Board *board, char *str) {
 		parse_fen(board, str+4);
 	else if (is_uci_command(str, "startpos"))
 		parse_fen(board, STARTING_FEN);
+
+	push_key(kh, board->key);
+
+	str = strstr(str, "moves");
+	if (!str)
+		return;
+
+	/* Play each of the moves after the position */
+	str += 5;
+	while (*str == ' ') {
+		Undo undo;
+		Move move = parse_move(++str);
+
+		if (!move)
+			break;
+
+		make_move(board, move, &undo);
+		push_key(kh, board->key);
+
+		str += move_promo(move) ? 5 : 4;
+	}
+}
+
+/* The number after a word in a go command, or 0 if it isn't there */
+static long long
+go_value(char *str, const char *word) {
+	char *p = strstr(str, word);
+
+	return p ? atoll(p + strlen(word)) : 0;
+}
+
+/*
+ * Play a move from the opening book if there is one, otherwise start
+ * searching. The search prints bestmove itself when it is done.
+ */
+void
+parse_go(Board *board, Key_History *kh, char *str) {
+	Search_Limits limits = { 0 };
+	char move[6];
+
+	if (own_book) {
+		Move m = probe_book(board);
+
+		if (m) {
+			move_str(m, move);
+			printf("bestmove %s\n", move);
+			return;
+		}
+	}
+
+	limits.depth = go_value(str, " depth ");
+	limits.nodes = go_value(str, " nodes ");
+	limits.time  = go_value(str, " movetime ");
+	limits.infinite = strstr(str, " infinite") != NULL;
+
+	long long time = go_value(str, board->turn == WHITE ? " wtime " :
+	                                                      " btime ");
+	long long inc = go_value(str, board->turn == WHITE ? " winc " :
+	                                                     " binc ");
+
+	if (!limits.time && time)
+		set_move_time(&limits, time, inc, go_value(str, " movestogo "));
+
+	start_search(board, kh, &limits, true);
+}
+
+/* setoption name <id> value <x> */
+void
+parse_setoption(char *str) {
+	char *name = str + 15;
+	char *value = strstr(str, " value ");
+
+	if (!value)
+		return;
+	value += 7;
+
+	/* Strip the newline that fgets leaves */
+	value[strcspn(value, "\r\n")] = '\0';
+
+	if (is_uci_command(name, "NUMA Binding"))
+		numa_binding = is_uci_command(value, "true");
+
+	else if (is_uci_command(name, "OwnBook"))
+		own_book = is_uci_command(value, "true");
+
+	else if (is_uci_command(name, "BookFile"))
+		snprintf(book_file, BOOK_FILE_LEN, "%s", value);
+
+	else if (is_uci_command(name, "BookBestMove"))
+		book_best_move = is_uci_command(value, "true");
+
+	else if (!set_search_option(&search_params, name, value))
+		return;
+
+	if (own_book && (is_uci_command(name, "OwnBook") ||
+		is_uci_command(name, "BookFile")) && !open_book(book_file))
+		printf("info string could not open book %s%s\n", book_file,
+			book_keys_valid() ? "" : ", the Polyglot key table is incomplete");
 }
 
 int
-main() {
+main(int argc, char **argv) {
 
 	init_attacks();
+	init_endgames();
+	init_numa();
+	init_book();
+	init_search();
+
+#ifdef TUNE
+	if (argc > 1 && !strcmp(argv[1], "tune"))
+		return tune(argc - 1, argv + 1);
+	if (argc > 1 && !strcmp(argv[1], "pack"))
+		return pack(argc - 1, argv + 1);
+#endif
+
+	if (argc > 1 && !strcmp(argv[1], "match"))
+		return match(argc - 1, argv + 1);
+
+	if (!init_threads()) {
+		printf("info string could not allocate the search thread\n");
+		return 1;
+	}
 
 	/* Remove the need to flush stdio */
 	setbuf(stdin, NULL);
@@ -69,9 +203,11 @@ main() {
 	char str[2048];
 
 	Board board;
+	static Key_History game_keys;
 
 	clear_board(&board);
 	parse_fen(&board, STARTING_FEN);
+	push_key(&game_keys, board.key);
 
 	/* UCI Loop */
 	while(fgets(str, 2048, stdin)) {
@@ -82,18 +218,48 @@ main() {
 		else if (is_uci_command(str, "quit"))
 			break;
 
+		else if (is_uci_command(str, "ucinewgame"))
+			new_game();
+
 		else if (is_uci_command(str, "uci"))
 			print_uci_info();
 
 		else if (is_uci_command(str, "position"))
-			parse_position(&board, str);
+			parse_position(&board, &game_keys, str);
+
+		else if (is_uci_command(str, "go"))
+			parse_go(&board, &game_keys, str);
+
+		else if (is_uci_command(str, "stop"))
+			stop_search();
+
+		else if (is_uci_command(str, "setoption"))
+			parse_setoption(str);
+
+		else if (is_uci_command(str, "benchsliders"))
+			bench_sliders();
+
+		else if (is_uci_command(str, "benchmake"))
+			bench_make();
+
+		else if (is_uci_command(str, "bench"))
+			bench(atoi(str + 5));
+
+		else if (is_uci_command(str, "sprt"))
+			parse_sprt(str);
 
 #ifdef DEBUG
-		else if (is_uci_command(str, "print"))
+		else if (is_uci_command(str, "print")) {
 			print_board(&board);
+			printf("Repetition: %s, upcoming repetition: %s\n\n",
+				is_repetition(&game_keys, &board, 0) ? "yes" : "no",
+				upcoming_repetition(&game_keys, &board, 0) ? "yes" : "no");
+		}
 #endif
 
 	}
 
+	quit_threads();
+
 	return 0;
 }
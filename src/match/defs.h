@@ -0,0 +1,39 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+typedef enum {
+	SPRT_CONTINUE,
+	SPRT_ACCEPT_H0,
+	SPRT_ACCEPT_H1
+} Sprt_Result;
+
+typedef struct {
+	double elo0, elo1;
+	double alpha, beta;
+
+	int wins, draws, losses;
+} Sprt;
+
+void init_sprt(Sprt *sprt, double elo0, double elo1,
+               double alpha, double beta);
+void sprt_add(Sprt *sprt, int wins, int draws, int losses);
+double sprt_llr(Sprt *sprt);
+Sprt_Result sprt_status(Sprt *sprt);
+void parse_sprt(char *str);
+
+int match(int argc, char **argv);
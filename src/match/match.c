@@ -0,0 +1,387 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the self-play match runner. It is run with
+ *
+ * nerdengine match <openings.epd> [key=value ...]
+ *
+ * and plays engine A against engine B inside this process, games=<n> games
+ * in total over threads=<n> threads. Both engines are this search, A with
+ * the options given as A.<Option>=<value> and B with B.<Option>=<value>,
+ * named as in setoption. Moves are either searched to nodes=<n> nodes or
+ * played on a clock of tc=<base>+<inc> seconds.
+ *
+ * Every opening is played twice with the colours swapped. Results are from
+ * A's point of view and go into an SPRT test with elo0, elo1, alpha and
+ * beta set the same way, which ends the match once it has an answer.
+ *
+ * Each thread sets up the Thread_Data of its two engines itself, so their
+ * arenas are on its node, and reuses them for every game it plays.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "../thread/defs.h"
+#include "../board/helpers.h"
+#include "../search/helpers.h"
+
+#define MAX_THREADS 256
+
+/* Games this long are called a draw */
+#define MAX_GAME_PLIES 600
+
+/* Room for the first four fields of an EPD line and " 0 1" */
+#define OPENING_LEN 100
+
+typedef enum {
+	BLACK_WINS, DRAWN, WHITE_WINS, ONGOING
+} Game_Result;
+
+typedef struct {
+	int id;
+
+	/* Engine A and engine B */
+	Thread_Data engines[2];
+	Key_History keys;
+} __attribute__((aligned(CACHE_LINE_SIZE))) Worker;
+
+static char (*openings)[OPENING_LEN];
+static int opening_cnt;
+
+static Search_Params params[2];
+
+/* Per move, nodes of 0 means the clock is used */
+static uint64_t tc_nodes;
+static int64_t tc_base, tc_inc;
+
+static int game_cnt;
+static int thread_cnt;
+
+/* Everything below is shared between the threads and needs the lock */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static Sprt sprt;
+static int next_pair;
+static bool done;
+
+/* Read the openings, one EPD or fen per line */
+static bool
+load_openings(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[512];
+	int size = 0;
+
+	if (!f)
+		return false;
+
+	while (fgets(line, sizeof(line), f)) {
+		char fields[4][OPENING_LEN];
+
+		if (sscanf(line, "%99s %99s %99s %99s", fields[0], fields[1],
+			fields[2], fields[3]) < 4)
+			continue;
+
+		if (opening_cnt == size) {
+			size = size ? size * 2 : 1024;
+			void *mem = realloc(openings, size * sizeof(*openings));
+			if (!mem)
+				break;
+			openings = mem;
+		}
+
+		/* Whatever follows the fields in an EPD is not part of the fen */
+		if (snprintf(openings[opening_cnt], OPENING_LEN, "%s %s %s %s 0 1",
+			fields[0], fields[1], fields[2], fields[3]) < OPENING_LEN)
+			opening_cnt++;
+	}
+
+	fclose(f);
+	return opening_cnt > 0;
+}
+
+static bool
+insufficient_material(Board *board) {
+	Bitboard minors = board->pieces[KNIGHT] | board->pieces[BISHOP];
+
+	return !(board->pieces[PAWN] | board->pieces[ROOK] |
+		board->pieces[QUEEN]) && popcnt(minors) <= 1;
+}
+
+static bool
+has_legal_move(Board *board) {
+	Move moves[MAX_MOVES];
+	int cnt = gen_moves(board, moves);
+
+	for (int i = 0; i < cnt; i++) {
+		Undo undo;
+
+		make_move(board, moves[i], &undo);
+		bool legal = !left_in_check(board);
+		undo_move(board, moves[i], &undo);
+
+		if (legal)
+			return true;
+	}
+
+	return false;
+}
+
+static Game_Result
+game_result(Board *board, Key_History *keys) {
+	if (!has_legal_move(board)) {
+		if (!in_check(board))
+			return DRAWN;
+		return board->turn == WHITE ? BLACK_WINS : WHITE_WINS;
+	}
+
+	/* At ply 0 a repetition has to have happened twice before */
+	if (board->half_move_cnt >= 100 || is_repetition(keys, board, 0) ||
+		insufficient_material(board))
+		return DRAWN;
+
+	return ONGOING;
+}
+
+/* Play a game from an opening, white is the index of the engine for white */
+static Game_Result
+play_game(Worker *w, const char *fen, int white) {
+	Board board;
+	int64_t clock[TURN_CNT] = { tc_base, tc_base };
+
+	clear_board(&board);
+	parse_fen(&board, fen);
+
+	clear_key_history(&w->keys);
+	push_key(&w->keys, board.key);
+
+	clear_thread_data(&w->engines[0]);
+	clear_thread_data(&w->engines[1]);
+
+	for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+		Game_Result result = game_result(&board, &w->keys);
+		if (result != ONGOING)
+			return result;
+
+		Turn t = board.turn;
+		Thread_Data *td = &w->engines[t == WHITE ? white : !white];
+		Search_Limits limits = { .nodes = tc_nodes };
+
+		if (!tc_nodes)
+			set_move_time(&limits, clock[t], tc_inc, 0);
+
+		*td->board = board;
+		copy_key_history(td->keys, &w->keys);
+		td->limits = limits;
+		atomic_store(&td->stop, false);
+
+		int64_t start = now_ms();
+		search(td);
+
+		if (!tc_nodes) {
+			clock[t] -= now_ms() - start;
+			if (clock[t] <= 0)
+				return t == WHITE ? BLACK_WINS : WHITE_WINS;
+			clock[t] += tc_inc;
+		}
+
+		Undo undo;
+		make_move(&board, td->best_move, &undo);
+		push_key(&w->keys, board.key);
+	}
+
+	return DRAWN;
+}
+
+static void
+print_progress() {
+	int n = sprt.wins + sprt.draws + sprt.losses;
+	double score = (sprt.wins + sprt.draws / 2.0) / n;
+	double elo = score > 0 && score < 1 ? -400 * log10(1 / score - 1) : 0;
+
+	printf("Games %d: +%d =%d -%d, elo %+.1f, LLR %.2f (%.2f, %.2f)\n", n,
+		sprt.wins, sprt.draws, sprt.losses, elo, sprt_llr(&sprt),
+		log(sprt.beta / (1 - sprt.alpha)), log((1 - sprt.beta) / sprt.alpha));
+}
+
+static void *
+worker_loop(void *arg) {
+	Worker *w = arg;
+
+	bind_thread(w->id);
+
+	if (!init_thread_data(&w->engines[0], 2 * w->id) ||
+		!init_thread_data(&w->engines[1], 2 * w->id + 1)) {
+		printf("Thread %d could not allocate its engines\n", w->id);
+		return NULL;
+	}
+
+	for (int e = 0; e < 2; e++)
+		w->engines[e].params = &params[e];
+
+	for (;;) {
+		pthread_mutex_lock(&lock);
+		int pair = done || 2 * next_pair >= game_cnt ? -1 : next_pair++;
+		pthread_mutex_unlock(&lock);
+
+		if (pair < 0)
+			break;
+
+		const char *fen = openings[pair % opening_cnt];
+		int wins = 0, draws = 0, losses = 0;
+
+		/* A as white, then A as black */
+		for (int white = 0; white < 2; white++) {
+			Game_Result r = play_game(w, fen, white);
+
+			if (r == DRAWN)
+				draws++;
+			else if ((r == WHITE_WINS) == (white == 0))
+				wins++;
+			else
+				losses++;
+		}
+
+		pthread_mutex_lock(&lock);
+		if (!done) {
+			sprt_add(&sprt, wins, draws, losses);
+			print_progress();
+			done = sprt_status(&sprt) != SPRT_CONTINUE;
+		}
+		pthread_mutex_unlock(&lock);
+	}
+
+	free_thread_data(&w->engines[0]);
+	free_thread_data(&w->engines[1]);
+
+	return NULL;
+}
+
+/* Apply A.<Option>=<value> or B.<Option>=<value> */
+static bool
+set_engine_option(const char *arg) {
+	const char *eq = strchr(arg, '=');
+	char name[64];
+
+	if ((arg[0] != 'A' && arg[0] != 'B') || arg[1] != '.' || !eq ||
+		eq - arg - 2 >= (int)sizeof(name) - 1)
+		return false;
+
+	/* set_search_option wants the name the way setoption has it */
+	snprintf(name, sizeof(name), "%.*s ", (int)(eq - arg - 2), arg + 2);
+
+	return set_search_option(&params[arg[0] - 'A'], name, eq + 1);
+}
+
+int
+match(int argc, char **argv) {
+	double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+	double base = 10, inc = 0.1;
+
+	if (argc < 2) {
+		printf("Usage: match <openings.epd> [games=<n>] [threads=<n>] "
+			"[nodes=<n> | tc=<base>+<inc>] [elo0=<elo>] [elo1=<elo>] "
+			"[alpha=<p>] [beta=<p>] [A.<Option>=<v>] [B.<Option>=<v>]\n");
+		return 1;
+	}
+
+	params[0] = params[1] = search_params;
+	game_cnt = 20000;
+	thread_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+	for (int i = 2; i < argc; i++) {
+		char *a = argv[i];
+
+		if (!strncmp(a, "games=", 6))
+			game_cnt = atoi(a + 6);
+		else if (!strncmp(a, "threads=", 8))
+			thread_cnt = atoi(a + 8);
+		else if (!strncmp(a, "nodes=", 6))
+			tc_nodes = strtoull(a + 6, NULL, 10);
+		else if (!strncmp(a, "tc=", 3) &&
+			sscanf(a + 3, "%lf+%lf", &base, &inc) >= 1)
+			tc_nodes = 0;
+		else if (!strncmp(a, "elo0=", 5))
+			elo0 = atof(a + 5);
+		else if (!strncmp(a, "elo1=", 5))
+			elo1 = atof(a + 5);
+		else if (!strncmp(a, "alpha=", 6))
+			alpha = atof(a + 6);
+		else if (!strncmp(a, "beta=", 5))
+			beta = atof(a + 5);
+		else if (!set_engine_option(a)) {
+			printf("Unknown argument %s\n", a);
+			return 1;
+		}
+	}
+
+	if (!(alpha > 0 && alpha < 1 && beta > 0 && beta < 1) ||
+		!(elo0 < elo1)) {
+		printf("alpha and beta have to be between 0 and 1 and elo0 below "
+			"elo1\n");
+		return 1;
+	}
+	if (!tc_nodes && base <= 0) {
+		printf("The time control needs a base time\n");
+		return 1;
+	}
+
+	tc_base = base * 1000;
+	tc_inc = inc * 1000;
+
+	if (thread_cnt < 1)
+		thread_cnt = 1;
+	if (thread_cnt > MAX_THREADS)
+		thread_cnt = MAX_THREADS;
+
+	if (!load_openings(argv[1])) {
+		printf("Could not load any openings from %s\n", argv[1]);
+		return 1;
+	}
+
+	init_sprt(&sprt, elo0, elo1, alpha, beta);
+
+	Worker *workers = aligned_alloc(CACHE_LINE_SIZE,
+		thread_cnt * sizeof(Worker));
+	if (!workers) {
+		printf("Could not allocate %d workers\n", thread_cnt);
+		return 1;
+	}
+
+	pthread_t threads[thread_cnt];
+
+	for (int i = 0; i < thread_cnt; i++) {
+		workers[i].id = i;
+		pthread_create(&threads[i], NULL, worker_loop, &workers[i]);
+	}
+
+	for (int i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("%s\n", (const char *[]){ "No decision", "H0 accepted",
+		"H1 accepted" }[sprt_status(&sprt)]);
+
+	free(workers);
+	free(openings);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the sequential probability ratio test used to decide
+ * whether a patch gains elo, from the running win/draw/loss count of a
+ * match.
+ *
+ * H0 is that the patch is elo0 stronger and H1 that it is elo1 stronger,
+ * with alpha and beta being the chances of accepting the wrong one. The log
+ * likelihood ratio uses the usual normal approximation of the trinomial
+ * distribution with logistic elo.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "defs.h"
+
+void
+init_sprt(Sprt *sprt, double elo0, double elo1, double alpha, double beta) {
+	sprt->elo0 = elo0;
+	sprt->elo1 = elo1;
+	sprt->alpha = alpha;
+	sprt->beta = beta;
+
+	sprt->wins = sprt->draws = sprt->losses = 0;
+}
+
+void
+sprt_add(Sprt *sprt, int wins, int draws, int losses) {
+	sprt->wins   += wins;
+	sprt->draws  += draws;
+	sprt->losses += losses;
+}
+
+/* Expected score for an elo difference */
+static inline double
+elo_score(double elo) {
+	return 1 / (1 + pow(10, -elo / 400));
+}
+
+double
+sprt_llr(Sprt *sprt) {
+	double n = sprt->wins + sprt->draws + sprt->losses;
+
+	if (!n)
+		return 0;
+
+	double w = sprt->wins / n, d = sprt->draws / n, l = sprt->losses / n;
+	double score = w + d / 2;
+	double var = w * (1 - score) * (1 - score) +
+		d * (0.5 - score) * (0.5 - score) +
+		l * score * score;
+
+	/* Until two different results have come up there is nothing to go on */
+	if (var == 0)
+		return 0;
+
+	double s0 = elo_score(sprt->elo0);
+	double s1 = elo_score(sprt->elo1);
+
+	return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * var);
+}
+
+Sprt_Result
+sprt_status(Sprt *sprt) {
+	double llr = sprt_llr(sprt);
+
+	if (llr >= log((1 - sprt->beta) / sprt->alpha))
+		return SPRT_ACCEPT_H1;
+	if (llr <= log(sprt->beta / (1 - sprt->alpha)))
+		return SPRT_ACCEPT_H0;
+
+	return SPRT_CONTINUE;
+}
+
+/*
+ * sprt <wins> <draws> <losses> <elo0> <elo1> [alpha] [beta]
+ *
+ * Check a result from outside the engine, alpha and beta default to 0.05.
+ */
+void
+parse_sprt(char *str) {
+	Sprt sprt;
+	int w, d, l;
+	double elo0, elo1, alpha = 0.05, beta = 0.05;
+
+	if (sscanf(str, "sprt %d %d %d %lf %lf %lf %lf",
+		&w, &d, &l, &elo0, &elo1, &alpha, &beta) < 5) {
+		printf("Usage: sprt <wins> <draws> <losses> <elo0> <elo1> "
+			"[alpha] [beta]\n");
+		return;
+	}
+
+	/* The bounds are logs of these, so anything outside (0, 1) is nonsense */
+	if (!(alpha > 0 && alpha < 1 && beta > 0 && beta < 1)) {
+		printf("alpha and beta have to be between 0 and 1\n");
+		return;
+	}
+	if (!(elo0 < elo1)) {
+		printf("elo0 has to be below elo1\n");
+		return;
+	}
+	if (w < 0 || d < 0 || l < 0) {
+		printf("Game counts can't be negative\n");
+		return;
+	}
+
+	init_sprt(&sprt, elo0, elo1, alpha, beta);
+	sprt_add(&sprt, w, d, l);
+
+	printf("LLR %.3f (%.3f, %.3f) %s\n", sprt_llr(&sprt),
+		log(beta / (1 - alpha)), log((1 - beta) / alpha),
+		(const char *[]){ "continue", "H0 accepted", "H1 accepted" }
+		[sprt_status(&sprt)]);
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the search benchmark, a fixed depth search of a set of
+ * positions. The node count is a signature of the search, any change that
+ * isn't meant to change the search should leave it the same.
+ *
+ * The searches run on the search thread just like go, so in debug builds
+ * the check that search doesn't allocate runs on every position.
+ */
+
+#include <stdio.h>
+
+#include "defs.h"
+#include "helpers.h"
+#include "../thread/defs.h"
+
+#define BENCH_DEPTH 7
+
+static const char *bench_fens[] = {
+	STARTING_FEN,
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 1",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 0 1",
+	"2r3k1/pp3ppp/4p3/3pP3/3P4/P4N2/1P3PPP/2R3K1 b - - 0 1",
+	"8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+	"6k1/5ppp/8/8/8/8/1Q3PPP/6K1 w - - 0 1",
+};
+
+#define BENCH_CNT (int)(sizeof(bench_fens) / sizeof(bench_fens[0]))
+
+void
+bench(int depth) {
+	static Key_History keys;
+	Search_Limits limits = { .depth = depth > 0 ? depth : BENCH_DEPTH };
+	uint64_t nodes = 0;
+	int64_t start = now_ms();
+
+	new_game();
+
+	for (int i = 0; i < BENCH_CNT; i++) {
+		Board board;
+
+		clear_board(&board);
+		parse_fen(&board, bench_fens[i]);
+		clear_key_history(&keys);
+		push_key(&keys, board.key);
+
+		start_search(&board, &keys, &limits, false);
+		wait_search();
+
+		nodes += search_nodes();
+	}
+
+	int64_t time = now_ms() - start;
+
+	printf("%llu nodes %llu nps\n", (unsigned long long)nodes,
+		(unsigned long long)(nodes * 1000 / (time ? time : 1)));
+}
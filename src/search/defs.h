@@ -0,0 +1,121 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../defs.h"
+#include "../board/defs.h"
+#include "../eval/defs.h"
+
+#define MAX_PLY   128
+#define MAX_MOVES 256
+
+/* Not a real move since it goes nowhere, marks a null move in the stack */
+#define NULL_MOVE 65
+
+enum {
+	VALUE_INF  = 32000,
+	VALUE_MATE = 31000,
+
+	/* Anything past this is a mate found by search */
+	VALUE_MATE_IN_MAX = VALUE_MATE - MAX_PLY,
+};
+
+/* The reduction table covers depths and move numbers up to this */
+#define LMR_MAX 64
+
+/*
+ * Margins and depth limits for the selective parts of search, all of which
+ * are UCI options so they can be tuned with matches. Margins are in
+ * centipawns, the LMR constants are in hundredths. Each search thread points
+ * at the set it uses, so the engines in a match can differ.
+ */
+typedef struct {
+	int nmp_depth;
+	int nmp_reduction;
+	int nmp_depth_div;
+	int nmp_eval_div;
+	int nmp_verify_depth;
+
+	int lmr_depth;
+	int lmr_moves;
+	int lmr_base;
+	int lmr_div;
+
+	int rfp_depth;
+	int rfp_margin;
+
+	int fp_depth;
+	int fp_base;
+	int fp_margin;
+
+	int lmp_depth;
+	int lmp_base;
+
+	int razor_depth;
+	int razor_margin;
+
+	/* Worked out from lmr_base and lmr_div by init_reductions */
+	int8_t reductions[LMR_MAX][LMR_MAX];
+} Search_Params;
+
+/*
+ * The keys of the positions played in the game and then searched, the
+ * current position last. Only the last 100 or so are ever looked at, so the
+ * oldest are dropped when it fills up.
+ */
+#define KEY_HISTORY_SIZE 1024
+
+typedef struct {
+	Key keys[KEY_HISTORY_SIZE];
+	uint16_t cnt;
+} Key_History;
+
+/* What go asked for, zero means no limit */
+typedef struct {
+	int depth;
+	uint64_t nodes;
+
+	/* In milliseconds, for this move */
+	int64_t time;
+
+	/* Keep going until stop even when the search is done */
+	bool infinite;
+} Search_Limits;
+
+typedef struct Thread_Data Thread_Data;
+
+extern Search_Params search_params;
+
+void init_search();
+void search(Thread_Data *td);
+int64_t now_ms();
+void set_move_time(Search_Limits *limits, int64_t time, int64_t inc,
+                   int moves_to_go);
+void bench(int depth);
+void init_reductions(Search_Params *sp);
+void print_search_options();
+bool set_search_option(Search_Params *sp, const char *name,
+                       const char *value);
+
+void clear_key_history(Key_History *kh);
+void copy_key_history(Key_History *dst, const Key_History *src);
+void trim_key_history(Key_History *kh);
+bool is_repetition(Key_History *kh, Board *board, int ply);
+bool upcoming_repetition(Key_History *kh, Board *board, int ply);
@@ -0,0 +1,134 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+ * The decisions made by the selective search at each node. Each one only
+ * looks at the depth, the static eval and the bounds, so they are kept here
+ * as inline functions to be called from the search loop. The parameters are
+ * passed in since every engine in a match has its own.
+ */
+
+#include <limits.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+/*
+ * Null move pruning. Without pieces other than pawns zugzwang is too likely
+ * for passing to be a fair test, and passing while in check is illegal.
+ */
+static inline bool
+can_null_move(const Search_Params *sp, Board *board, Attack_Info *ai,
+              int depth, Value eval, Value beta) {
+	Bitboard pieces = board->sides[board->turn] &
+		~(board->pieces[PAWN] | board->pieces[KING]);
+
+	return depth >= sp->nmp_depth && eval >= beta && pieces &&
+		!get_attack_info(board, ai)->checkers;
+}
+
+/* The further eval is above beta the more the null move search is reduced */
+static inline int
+null_move_reduction(const Search_Params *sp, int depth, Value eval,
+                    Value beta) {
+	int r = (eval - beta) / sp->nmp_eval_div;
+
+	return sp->nmp_reduction + depth / sp->nmp_depth_div + (r < 3 ? r : 3);
+}
+
+/*
+ * At high depth a null move cutoff is checked by searching again without
+ * null moves at the reduced depth, which catches zugzwang.
+ */
+static inline bool
+null_move_verify(const Search_Params *sp, int depth) {
+	return depth >= sp->nmp_verify_depth;
+}
+
+/*
+ * Late move reductions, for moves after the first few. Captures are reduced
+ * less and positions that got worse since our last move are reduced more.
+ */
+static inline int
+lmr_reduction(const Search_Params *sp, int depth, int move_num, bool improving,
+              bool quiet) {
+	if (depth < sp->lmr_depth || move_num < sp->lmr_moves)
+		return 0;
+
+	int r = sp->reductions[depth < LMR_MAX ? depth : LMR_MAX - 1]
+	                      [move_num < LMR_MAX ? move_num : LMR_MAX - 1];
+
+	r += !improving - !quiet;
+
+	/* Always leave at least one ply to search */
+	if (r > depth - 1)
+		r = depth - 1;
+
+	return r > 0 ? r : 0;
+}
+
+/* Reverse futility pruning, eval is so far above beta it will hold */
+static inline bool
+rfp_prune(const Search_Params *sp, int depth, Value eval, Value beta,
+          bool improving) {
+	return depth <= sp->rfp_depth &&
+		eval - sp->rfp_margin * (depth - improving) >= beta;
+}
+
+/* Futility pruning, a quiet move is not going to bring eval up to alpha */
+static inline bool
+futility_prune(const Search_Params *sp, int depth, Value eval, Value alpha) {
+	return depth <= sp->fp_depth &&
+		eval + sp->fp_base + sp->fp_margin * depth <= alpha;
+}
+
+/* Late move pruning, the number of quiet moves searched before the rest go */
+static inline int
+lmp_limit(const Search_Params *sp, int depth, bool improving) {
+	if (depth > sp->lmp_depth)
+		return INT_MAX;
+
+	return (sp->lmp_base + depth * depth) / (2 - improving);
+}
+
+/* Razoring, eval is so far below alpha only a quiescence search is done */
+static inline bool
+razor(const Search_Params *sp, int depth, Value eval, Value alpha) {
+	return depth <= sp->razor_depth &&
+		eval + sp->razor_margin * depth < alpha;
+}
+
+/* Has to be called with the key of every position made, null moves too */
+static inline void
+push_key(Key_History *kh, Key key) {
+	if (kh->cnt == KEY_HISTORY_SIZE)
+		trim_key_history(kh);
+
+	kh->keys[kh->cnt++] = key;
+}
+
+static inline void
+pop_key(Key_History *kh) {
+	kh->cnt--;
+}
+
+/* Check extensions, so checks near the horizon are always seen through */
+static inline int
+extension(Board *board, Attack_Info *ai) {
+	return get_attack_info(board, ai)->checkers != 0ULL;
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the parameters of the selective search, the UCI options
+ * that set them and the late move reduction table.
+ *
+ * Reductions grow with the log of both the depth and the move number, so the
+ * table is worked out once at startup instead of calling log at every node.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defs.h"
+
+Search_Params search_params = {
+	.nmp_depth        = 3,
+	.nmp_reduction    = 3,
+	.nmp_depth_div    = 3,
+	.nmp_eval_div     = 200,
+	.nmp_verify_depth = 12,
+
+	.lmr_depth = 3,
+	.lmr_moves = 3,
+	.lmr_base  = 75,
+	.lmr_div   = 225,
+
+	.rfp_depth  = 8,
+	.rfp_margin = 80,
+
+	.fp_depth  = 6,
+	.fp_base   = 100,
+	.fp_margin = 90,
+
+	.lmp_depth = 8,
+	.lmp_base  = 3,
+
+	.razor_depth  = 3,
+	.razor_margin = 250,
+};
+
+/* Options are found by their offset, so they can be set in any copy */
+#define OPTION(name, field, min, max) \
+	{ name, offsetof(Search_Params, field), min, max }
+
+static const struct {
+	const char *name;
+	size_t offset;
+	int min, max;
+} options[] = {
+	OPTION("NullMoveDepth",       nmp_depth,        1,   20),
+	OPTION("NullMoveReduction",   nmp_reduction,    1,    6),
+	OPTION("NullMoveDepthDiv",    nmp_depth_div,    1,   12),
+	OPTION("NullMoveEvalDiv",     nmp_eval_div,    10, 1000),
+	OPTION("NullMoveVerifyDepth", nmp_verify_depth, 1,  128),
+
+	OPTION("LMRDepth", lmr_depth,  1,  20),
+	OPTION("LMRMoves", lmr_moves,  1,  20),
+	OPTION("LMRBase",  lmr_base,   0, 300),
+	OPTION("LMRDiv",   lmr_div,   50, 600),
+
+	OPTION("RFPDepth",  rfp_depth,  0,  20),
+	OPTION("RFPMargin", rfp_margin, 0, 500),
+
+	OPTION("FPDepth",  fp_depth,  0,  20),
+	OPTION("FPBase",   fp_base,   0, 500),
+	OPTION("FPMargin", fp_margin, 0, 500),
+
+	OPTION("LMPDepth", lmp_depth, 0, 20),
+	OPTION("LMPBase",  lmp_base,  0, 20),
+
+	OPTION("RazorDepth",  razor_depth,  0,    8),
+	OPTION("RazorMargin", razor_margin, 0, 1000),
+};
+
+#define OPTION_CNT (int)(sizeof(options) / sizeof(options[0]))
+
+/* Where option i is kept in a set of parameters */
+static inline int *
+option_value(Search_Params *sp, int i) {
+	return (int *)((char *)sp + options[i].offset);
+}
+
+void
+init_reductions(Search_Params *sp) {
+	double base = sp->lmr_base / 100.0;
+	double div  = sp->lmr_div  / 100.0;
+
+	for (int depth = 0; depth < LMR_MAX; depth++)
+		for (int move_num = 0; move_num < LMR_MAX; move_num++)
+			sp->reductions[depth][move_num] = depth && move_num ?
+				base + log(depth) * log(move_num) / div : 0;
+}
+
+void
+init_search() {
+	init_reductions(&search_params);
+}
+
+void
+print_search_options() {
+	for (int i = 0; i < OPTION_CNT; i++)
+		printf("option name %s type spin default %d min %d max %d\n",
+			options[i].name, *option_value(&search_params, i),
+			options[i].min, options[i].max);
+}
+
+/*
+ * Set an option in a set of parameters, returns false if there is no option
+ * with that name. The name is followed by a space, as in setoption.
+ */
+bool
+set_search_option(Search_Params *sp, const char *name, const char *value) {
+	for (int i = 0; i < OPTION_CNT; i++) {
+		size_t len = strlen(options[i].name);
+
+		if (strncmp(name, options[i].name, len) || name[len] != ' ')
+			continue;
+
+		int v = atoi(value);
+		*option_value(sp, i) = v < options[i].min ? options[i].min :
+		                       v > options[i].max ? options[i].max : v;
+
+		if (options[i].offset == offsetof(Search_Params, lmr_base) ||
+			options[i].offset == offsetof(Search_Params, lmr_div))
+			init_reductions(sp);
+
+		return true;
+	}
+
+	return false;
+}
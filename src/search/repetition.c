@@ -0,0 +1,136 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains repetition detection over the key history.
+ *
+ * A position can only repeat back to the last capture or pawn move, so the
+ * scan back is bounded by the half move counter, and only every other key is
+ * looked at since the side to move has to be the same.
+ *
+ * upcoming_repetition finds positions where the side to move could repeat
+ * an earlier position with its next move, using the cuckoo table in
+ * "board/zobrist.c". Search can then treat the node as at least a draw
+ * before generating any moves. The method is from Marcel van Kervinck's
+ * "The Cuckoo Cycle" paper.
+ */
+
+#include <string.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+void
+clear_key_history(Key_History *kh) {
+	kh->cnt = 0;
+}
+
+void
+copy_key_history(Key_History *dst, const Key_History *src) {
+	memcpy(dst->keys, src->keys, src->cnt * sizeof(Key));
+	dst->cnt = src->cnt;
+}
+
+/* Drop the oldest half, which is far older than anything that can repeat */
+void
+trim_key_history(Key_History *kh) {
+	memmove(kh->keys, kh->keys + KEY_HISTORY_SIZE / 2,
+		(kh->cnt - KEY_HISTORY_SIZE / 2) * sizeof(Key));
+	kh->cnt -= KEY_HISTORY_SIZE / 2;
+}
+
+/* The furthest back a repetition of the current position could be */
+static inline int
+repetition_end(Key_History *kh, Board *board) {
+	return board->half_move_cnt < kh->cnt - 1 ? board->half_move_cnt :
+	                                            kh->cnt - 1;
+}
+
+/*
+ * Whether the position is a draw by repetition. A repetition inside the
+ * search tree counts straight away, since the side that could avoid it
+ * could have done so already. One from before the search started has to
+ * happen twice, which makes it a real threefold repetition.
+ */
+bool
+is_repetition(Key_History *kh, Board *board, int ply) {
+	Key *back = &kh->keys[kh->cnt - 1];
+	int end = repetition_end(kh, board);
+	bool seen = false;
+
+	for (int i = 4; i <= end; i += 2) {
+		if (back[-i] != board->key)
+			continue;
+
+		if (i < ply || seen)
+			return true;
+
+		seen = true;
+	}
+
+	return false;
+}
+
+/*
+ * Whether the side to move has a move that repeats an earlier position.
+ * back[-i] is the key i plies ago, and other tracks whether the moves in
+ * between cancel out so that one move is all the difference.
+ */
+bool
+upcoming_repetition(Key_History *kh, Board *board, int ply) {
+	Key *back = &kh->keys[kh->cnt - 1];
+	int end = repetition_end(kh, board);
+
+	if (end < 3)
+		return false;
+
+	Key other = board->key ^ back[-1] ^ zobrist_turn;
+
+	for (int i = 3; i <= end; i += 2) {
+		other ^= back[-(i - 1)] ^ back[-i] ^ zobrist_turn;
+
+		if (other)
+			continue;
+
+		Move move = cuckoo_move(board->key ^ back[-i]);
+		if (!move)
+			continue;
+
+		Square a = move_from(move);
+		Square b = move_to(move);
+
+		if (between(a, b) & board->pieces[ALL_PIECES])
+			continue;
+
+		if (i < ply)
+			return true;
+
+		/*
+		 * From before the search started it has to be our own piece
+		 * going back, and that position has to have come up before too
+		 */
+		Piece p = board->mailbox[a] ? board->mailbox[a] : board->mailbox[b];
+		if (piece_side(p) != board->turn)
+			continue;
+
+		for (int j = i + 4; j <= end; j += 2)
+			if (back[-j] == back[-i])
+				return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,580 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the search, an iterative deepening principal variation
+ * search with a quiescence search at the leaves.
+ *
+ * Everything a search touches is in the thread's Thread_Data, which is set
+ * up before go, so nothing here allocates. Moves are ordered with the move
+ * from the last iteration first at the root, then captures by most valuable
+ * victim and least valuable attacker, then killers and the history table.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "defs.h"
+#include "helpers.h"
+#include "../board/helpers.h"
+#include "../thread/defs.h"
+
+/* Time kept back for talking to the GUI, in milliseconds */
+#define MOVE_OVERHEAD 30
+
+/* Limit on history scores, they have to fit in an int16_t */
+#define HISTORY_MAX 16384
+
+enum {
+	SCORE_BEST    = 3000000,
+	SCORE_CAPTURE = 2000000,
+	SCORE_KILLER  = 1000000,
+};
+
+static const Value piece_values[] = {
+	0, PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, 0
+};
+
+int64_t
+now_ms() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Work out how long to spend on a move from the clock. The search stops
+ * starting new iterations at half of this, so on average it uses less.
+ */
+void
+set_move_time(Search_Limits *limits, int64_t time, int64_t inc,
+              int moves_to_go) {
+	int64_t t = time / (moves_to_go ? moves_to_go : 30) + inc * 3 / 4;
+
+	if (t > time - MOVE_OVERHEAD)
+		t = time - MOVE_OVERHEAD;
+
+	limits->time = t > 1 ? t : 1;
+}
+
+static inline Value
+mated_in(int ply) {
+	return -VALUE_MATE + ply;
+}
+
+static inline Value
+mate_in(int ply) {
+	return VALUE_MATE - ply;
+}
+
+static inline bool
+stopped(Thread_Data *td) {
+	return atomic_load_explicit(&td->stop, memory_order_relaxed);
+}
+
+/* Results are thrown away once this is true, except in the first iteration */
+static inline bool
+aborted(Thread_Data *td) {
+	return td->root_depth > 1 && stopped(td);
+}
+
+/*
+ * Whether the search is out of nodes or time. The clock is only read every
+ * 1024 nodes, and the first iteration always finishes so there is a move to
+ * play.
+ */
+static inline bool
+should_stop(Thread_Data *td) {
+	if (td->root_depth == 1)
+		return false;
+
+	if (stopped(td))
+		return true;
+
+	if ((td->limits.nodes && td->nodes >= td->limits.nodes) ||
+		(td->limits.time && !(td->nodes & 1023) &&
+		 now_ms() - td->start_time >= td->limits.time)) {
+		atomic_store_explicit(&td->stop, true, memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+/* Captures, en passant and promotions */
+static inline bool
+is_noisy(Board *board, Move move) {
+	Square to = move_to(move);
+
+	return board->mailbox[to] || move_promo(move) ||
+		(to == board->en_pas_square &&
+		 piece_type(board->mailbox[move_from(move)]) == PAWN);
+}
+
+static void
+score_moves(Thread_Data *td, Ply *p, Move best) {
+	Board *board = td->board;
+
+	for (int i = 0; i < p->move_cnt; i++) {
+		Move m = p->moves[i];
+		Square from = move_from(m);
+		Square to = move_to(m);
+
+		if (m == best) {
+			p->scores[i] = SCORE_BEST;
+		} else if (is_noisy(board, m)) {
+			Piece victim = board->mailbox[to];
+			Value v = victim ? piece_values[piece_type(victim)] : PAWN_VALUE;
+
+			p->scores[i] = SCORE_CAPTURE + v * 16 +
+				piece_values[move_promo(m)] -
+				piece_type(board->mailbox[from]);
+		} else if (m == p->killers[0]) {
+			p->scores[i] = SCORE_KILLER + 1;
+		} else if (m == p->killers[1]) {
+			p->scores[i] = SCORE_KILLER;
+		} else {
+			p->scores[i] = td->history[board->turn][from][to];
+		}
+	}
+}
+
+/* Swap the best scored move left of i into place i and return it */
+static inline Move
+next_move(Ply *p, int i) {
+	int best = i;
+
+	for (int j = i + 1; j < p->move_cnt; j++)
+		if (p->scores[j] > p->scores[best])
+			best = j;
+
+	Move m = p->moves[best];
+	int s = p->scores[best];
+
+	p->moves[best] = p->moves[i];
+	p->scores[best] = p->scores[i];
+	p->moves[i] = m;
+	p->scores[i] = s;
+
+	return m;
+}
+
+/* Move history towards bonus, by less the closer it already is */
+static inline void
+update_history(int16_t *h, int bonus) {
+	int b = bonus < HISTORY_MAX ? bonus : HISTORY_MAX;
+
+	if (b < -HISTORY_MAX)
+		b = -HISTORY_MAX;
+
+	*h += b - *h * (b < 0 ? -b : b) / HISTORY_MAX;
+}
+
+/* A quiet move caused a cutoff, the quiets tried before it did not */
+static void
+update_quiets(Thread_Data *td, Ply *p, int depth, Move best, Move *quiets,
+              int quiet_cnt) {
+	Turn t = td->board->turn;
+	int bonus = depth * depth;
+
+	if (p->killers[0] != best) {
+		p->killers[1] = p->killers[0];
+		p->killers[0] = best;
+	}
+
+	update_history(&td->history[t][move_from(best)][move_to(best)], bonus);
+
+	for (int i = 0; i < quiet_cnt; i++)
+		update_history(&td->history[t][move_from(quiets[i])]
+		                              [move_to(quiets[i])], -bonus);
+}
+
+/* The pv of this ply is move followed by the pv of the next */
+static inline void
+update_pv(Ply *p, Move move) {
+	Ply *child = p + 1;
+
+	p->pv[0] = move;
+	memcpy(p->pv + 1, child->pv, child->pv_len * sizeof(Move));
+	p->pv_len = child->pv_len + 1;
+}
+
+static Value
+qsearch(Thread_Data *td, int ply, Value alpha, Value beta) {
+	Board *board = td->board;
+	Ply *p = &td->stack[ply];
+	bool check = in_check(board);
+	Value best = -VALUE_INF;
+
+	p->pv_len = 0;
+	td->nodes++;
+
+	if (should_stop(td))
+		return VALUE_DRAW;
+
+	if (ply > td->sel_depth)
+		td->sel_depth = ply;
+
+	if (board->half_move_cnt >= 100)
+		return VALUE_DRAW;
+
+	if (ply >= MAX_PLY - 1)
+		return check ? VALUE_DRAW : evaluate(board);
+
+	if (check) {
+		p->move_cnt = gen_moves(board, p->moves);
+	} else {
+		best = correct_eval(board, td->eval_cache,
+			raw_eval(board, td->eval_cache));
+
+		if (best >= beta)
+			return best;
+		if (best > alpha)
+			alpha = best;
+
+		p->move_cnt = gen_captures(board, p->moves);
+	}
+
+	score_moves(td, p, NO_MOVE);
+
+	int legal = 0;
+
+	for (int i = 0; i < p->move_cnt; i++) {
+		Move move = next_move(p, i);
+
+		make_move(board, move, &p->undo);
+		if (left_in_check(board)) {
+			undo_move(board, move, &p->undo);
+			continue;
+		}
+
+		legal++;
+		p->move = move;
+		push_key(td->keys, board->key);
+
+		Value v = -qsearch(td, ply + 1, -beta, -alpha);
+
+		pop_key(td->keys);
+		undo_move(board, move, &p->undo);
+
+		if (aborted(td))
+			return VALUE_DRAW;
+
+		if (v > best) {
+			best = v;
+
+			if (v > alpha) {
+				alpha = v;
+				update_pv(p, move);
+
+				if (alpha >= beta)
+					break;
+			}
+		}
+	}
+
+	if (check && !legal)
+		return mated_in(ply);
+
+	return best;
+}
+
+/*
+ * The attack info of a ply is cleared by whoever made the move leading to
+ * it, since the check extension already needs it before the ply is searched.
+ */
+static Value
+negamax(Thread_Data *td, int ply, int depth, Value alpha, Value beta) {
+	const Search_Params *sp = td->params;
+	Board *board = td->board;
+	Ply *p = &td->stack[ply];
+	Ply *child = p + 1;
+	bool root = ply == 0;
+	bool pv_node = beta - alpha > 1;
+
+	if (depth <= 0)
+		return qsearch(td, ply, alpha, beta);
+
+	p->pv_len = 0;
+	td->nodes++;
+
+	if (should_stop(td))
+		return VALUE_DRAW;
+
+	if (ply > td->sel_depth)
+		td->sel_depth = ply;
+
+	bool check = get_attack_info(board, &p->attacks)->checkers;
+
+	if (!root) {
+		if (board->half_move_cnt >= 100 ||
+			is_repetition(td->keys, board, ply))
+			return VALUE_DRAW;
+
+		if (ply >= MAX_PLY - 1)
+			return check ? VALUE_DRAW : evaluate(board);
+
+		/* Nothing here can beat a mate that was already found */
+		alpha = alpha > mated_in(ply) ? alpha : mated_in(ply);
+		beta = beta < mate_in(ply + 1) ? beta : mate_in(ply + 1);
+		if (alpha >= beta)
+			return alpha;
+
+		if (alpha < VALUE_DRAW &&
+			upcoming_repetition(td->keys, board, ply)) {
+			alpha = VALUE_DRAW;
+			if (alpha >= beta)
+				return alpha;
+		}
+	}
+
+	Value raw = check ? -VALUE_INF : raw_eval(board, td->eval_cache);
+	Value eval = p->static_eval = check ? -VALUE_INF :
+		correct_eval(board, td->eval_cache, raw);
+
+	/* Whether things got better since our last move */
+	bool improving = !check && ply >= 2 && eval > p[-2].static_eval;
+
+	child->killers[0] = child->killers[1] = NO_MOVE;
+
+	if (!pv_node && !check) {
+		if (rfp_prune(sp, depth, eval, beta, improving))
+			return eval;
+
+		if (razor(sp, depth, eval, alpha)) {
+			Value v = qsearch(td, ply, alpha, beta);
+
+			if (v <= alpha)
+				return v;
+		}
+
+		if (!td->no_null_move && p[-1].move != NULL_MOVE &&
+			can_null_move(sp, board, &p->attacks, depth, eval, beta)) {
+			int r = null_move_reduction(sp, depth, eval, beta);
+
+			p->move = NULL_MOVE;
+			make_null_move(board, &p->undo);
+			clear_attack_info(&child->attacks);
+			push_key(td->keys, board->key);
+
+			Value v = -negamax(td, ply + 1, depth - 1 - r, -beta, -beta + 1);
+
+			pop_key(td->keys);
+			undo_null_move(board, &p->undo);
+
+			if (aborted(td))
+				return VALUE_DRAW;
+
+			if (v >= beta) {
+				/* A mate after passing is not proven */
+				if (v >= VALUE_MATE_IN_MAX)
+					v = beta;
+
+				if (!null_move_verify(sp, depth))
+					return v;
+
+				td->no_null_move = true;
+				Value verify = negamax(td, ply, depth - 1 - r, beta - 1, beta);
+				td->no_null_move = false;
+
+				if (verify >= beta)
+					return v;
+			}
+		}
+	}
+
+	p->move_cnt = gen_moves(board, p->moves);
+	score_moves(td, p, root ? td->best_move : NO_MOVE);
+
+	Value old_alpha = alpha;
+	Value best = -VALUE_INF;
+	Move best_move = NO_MOVE;
+	Move quiets[64];
+	int quiet_cnt = 0;
+	int quiets_seen = 0;
+	int legal = 0;
+
+	for (int i = 0; i < p->move_cnt; i++) {
+		Move move = next_move(p, i);
+		bool quiet = !is_noisy(board, move);
+
+		/* Once one move has avoided being mated, prune late quiets */
+		if (!root && !check && quiet && best > -VALUE_MATE_IN_MAX &&
+			(quiets_seen >= lmp_limit(sp, depth, improving) ||
+			 futility_prune(sp, depth, eval, alpha)))
+			continue;
+
+		make_move(board, move, &p->undo);
+		if (left_in_check(board)) {
+			undo_move(board, move, &p->undo);
+			continue;
+		}
+
+		legal++;
+		quiets_seen += quiet;
+		p->move = move;
+		clear_attack_info(&child->attacks);
+		push_key(td->keys, board->key);
+
+		int new_depth = depth - 1 + extension(board, &child->attacks);
+		Value v;
+
+		if (legal == 1) {
+			v = -negamax(td, ply + 1, new_depth, -beta, -alpha);
+		} else {
+			int r = check ? 0 :
+				lmr_reduction(sp, depth, legal, improving, quiet);
+
+			if (r && pv_node)
+				r--;
+
+			v = -negamax(td, ply + 1, new_depth - r, -alpha - 1, -alpha);
+
+			if (v > alpha && r)
+				v = -negamax(td, ply + 1, new_depth, -alpha - 1, -alpha);
+
+			if (v > alpha && v < beta)
+				v = -negamax(td, ply + 1, new_depth, -beta, -alpha);
+		}
+
+		pop_key(td->keys);
+		undo_move(board, move, &p->undo);
+
+		if (aborted(td))
+			return VALUE_DRAW;
+
+		if (v > best) {
+			best = v;
+
+			if (v > alpha) {
+				alpha = v;
+				best_move = move;
+				update_pv(p, move);
+
+				if (alpha >= beta) {
+					if (quiet)
+						update_quiets(td, p, depth, move, quiets,
+							quiet_cnt);
+					break;
+				}
+			}
+		}
+
+		if (quiet && quiet_cnt < 64)
+			quiets[quiet_cnt++] = move;
+	}
+
+	if (!legal)
+		return check ? mated_in(ply) : VALUE_DRAW;
+
+	/*
+	 * Teach the correction table when the score is trustworthy, that is
+	 * when it is not a mate and it is on the side of the bound it proves
+	 */
+	if (!check && (!best_move || !is_noisy(board, best_move)) &&
+		best > -VALUE_MATE_IN_MAX && best < VALUE_MATE_IN_MAX &&
+		!(best >= beta && best <= p->static_eval) &&
+		!(best <= old_alpha && best >= p->static_eval))
+		update_correction(board, td->eval_cache, depth, best - raw);
+
+	return best;
+}
+
+/* One info line per iteration, written in one go so it isn't interleaved */
+static void
+print_info(Thread_Data *td, int depth, Value v) {
+	int64_t time = now_ms() - td->start_time;
+	char buf[2048];
+	char move[6];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "info depth %d seldepth %d score ",
+		depth, td->sel_depth);
+
+	if (v >= VALUE_MATE_IN_MAX)
+		len += snprintf(buf + len, sizeof(buf) - len, "mate %d",
+			(VALUE_MATE - v + 1) / 2);
+	else if (v <= -VALUE_MATE_IN_MAX)
+		len += snprintf(buf + len, sizeof(buf) - len, "mate %d",
+			-(VALUE_MATE + v) / 2);
+	else
+		len += snprintf(buf + len, sizeof(buf) - len, "cp %d", v);
+
+	len += snprintf(buf + len, sizeof(buf) - len,
+		" nodes %llu nps %llu time %lld pv",
+		(unsigned long long)td->nodes,
+		(unsigned long long)(td->nodes * 1000 / (time ? time : 1)),
+		(long long)time);
+
+	for (int i = 0; i < td->stack[0].pv_len; i++) {
+		move_str(td->stack[0].pv[i], move);
+		len += snprintf(buf + len, sizeof(buf) - len, " %s", move);
+	}
+
+	printf("%s\n", buf);
+}
+
+/*
+ * Search the thread's board with iterative deepening until a limit is hit.
+ * The best move of the last iteration that finished ends up in best_move,
+ * or NO_MOVE when there are no legal moves.
+ */
+void
+search(Thread_Data *td) {
+	int max_depth = td->limits.depth && td->limits.depth < MAX_PLY - 1 ?
+		td->limits.depth : MAX_PLY - 1;
+
+	td->nodes = 0;
+	td->sel_depth = 0;
+	td->start_time = now_ms();
+	td->best_move = NO_MOVE;
+	td->best_value = VALUE_DRAW;
+
+	clear_attack_info(&td->stack[0].attacks);
+
+	for (int depth = 1; depth <= max_depth; depth++) {
+		td->root_depth = depth;
+
+		Value v = negamax(td, 0, depth, -VALUE_INF, VALUE_INF);
+
+		if (aborted(td))
+			break;
+
+		td->best_move = td->stack[0].pv_len ? td->stack[0].pv[0] : NO_MOVE;
+		td->best_value = v;
+
+		if (td->uci_output)
+			print_info(td, depth, v);
+
+		if (stopped(td) || !td->best_move ||
+			(td->limits.nodes && td->nodes >= td->limits.nodes))
+			break;
+
+		/* The next iteration would not finish in time */
+		if (td->limits.time &&
+			(now_ms() - td->start_time) * 2 > td->limits.time)
+			break;
+	}
+
+	/* go infinite has to wait for stop before giving a move */
+	while (td->limits.infinite && !stopped(td)) {
+		struct timespec ts = { 0, 1000000 };
+		nanosleep(&ts, NULL);
+	}
+}
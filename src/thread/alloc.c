@@ -0,0 +1,67 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file counts heap allocations in debug builds, so that anything that
+ * allocates after go can be caught. The debug build links with --wrap for
+ * each of these, which sends our calls here instead of to libc.
+ */
+
+#ifdef DEBUG
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "defs.h"
+
+static atomic_size_t allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *mem, size_t size);
+void *__real_aligned_alloc(size_t align, size_t size);
+
+void *
+__wrap_malloc(size_t size) {
+	allocs++;
+	return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t n, size_t size) {
+	allocs++;
+	return __real_calloc(n, size);
+}
+
+void *
+__wrap_realloc(void *mem, size_t size) {
+	allocs++;
+	return __real_realloc(mem, size);
+}
+
+void *
+__wrap_aligned_alloc(size_t align, size_t size) {
+	allocs++;
+	return __real_aligned_alloc(align, size);
+}
+
+size_t
+heap_alloc_cnt() {
+	return allocs;
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the arena that search threads keep all of their state
+ * in, so that search never has to call into the allocator.
+ *
+ * Every allocation is rounded up to whole cache lines, so two tables never
+ * share a line and threads never write to the same line by accident.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+
+static inline size_t
+cache_align(size_t size) {
+	return (size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+}
+
+bool
+init_arena(Arena *arena, size_t size) {
+	arena->size = cache_align(size);
+	arena->used = 0;
+	arena->base = node_alloc(arena->size);
+
+	return arena->base;
+}
+
+void *
+arena_alloc(Arena *arena, size_t size) {
+	size = cache_align(size);
+
+	assert(arena->used + size <= arena->size);
+	if (arena->used + size > arena->size)
+		return NULL;
+
+	void *mem = arena->base + arena->used;
+	arena->used += size;
+
+	return mem;
+}
+
+void
+reset_arena(Arena *arena) {
+	arena->used = 0;
+}
+
+void
+free_arena(Arena *arena) {
+	node_free(arena->base);
+
+	arena->base = NULL;
+	arena->size = arena->used = 0;
+}
+
+/*
+ * Set up the state of a search thread. Has to be called from the thread
+ * itself after bind_thread, see node_alloc.
+ */
+bool
+init_thread_data(Thread_Data *td, int id) {
+	size_t board_size   = sizeof(*td->board);
+	size_t stack_size   = MAX_PLY * sizeof(Ply);
+	size_t history_size = TURN_CNT * sizeof(*td->history);
+	size_t keys_size    = sizeof(*td->keys);
+	size_t eval_size    = sizeof(*td->eval_cache);
+
+	td->id = id;
+
+	if (!init_arena(&td->arena, cache_align(board_size) +
+		cache_align(stack_size) + cache_align(history_size) +
+		cache_align(keys_size) + cache_align(eval_size)))
+		return false;
+
+	td->board      = arena_alloc(&td->arena, board_size);
+	td->stack      = arena_alloc(&td->arena, stack_size);
+	td->history    = arena_alloc(&td->arena, history_size);
+	td->keys       = arena_alloc(&td->arena, keys_size);
+	td->eval_cache = arena_alloc(&td->arena, eval_size);
+
+	td->params = &search_params;
+	memset(&td->limits, 0, sizeof(td->limits));
+	td->uci_output = false;
+	atomic_init(&td->stop, false);
+
+	clear_thread_data(td);
+
+	return true;
+}
+
+/* Forget everything learned from earlier games, for ucinewgame */
+void
+clear_thread_data(Thread_Data *td) {
+	clear_board(td->board);
+
+	for (int ply = 0; ply < MAX_PLY; ply++) {
+		clear_attack_info(&td->stack[ply].attacks);
+		td->stack[ply].killers[0] = td->stack[ply].killers[1] = NO_MOVE;
+	}
+
+	memset(td->history, 0, TURN_CNT * sizeof(*td->history));
+	clear_key_history(td->keys);
+	clear_eval_cache(td->eval_cache);
+
+	td->nodes = 0;
+	td->no_null_move = false;
+	td->best_move = NO_MOVE;
+	td->best_value = VALUE_DRAW;
+}
+
+void
+free_thread_data(Thread_Data *td) {
+	free_arena(&td->arena);
+
+	td->board = NULL;
+	td->stack = NULL;
+	td->history = NULL;
+	td->keys = NULL;
+	td->eval_cache = NULL;
+}
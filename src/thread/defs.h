@@ -0,0 +1,131 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../defs.h"
+#include "../board/defs.h"
+#include "../eval/defs.h"
+#include "../search/defs.h"
+
+/* Upper limit on the number of NUMA nodes we keep track of */
+#define MAX_NODES 64
+
+/* Whether search threads get pinned to the cpus of a single node */
+extern bool numa_binding;
+
+void init_numa();
+int node_cnt();
+int thread_node(int thread_id);
+void bind_thread(int thread_id);
+void *node_alloc(size_t size);
+void node_free(void *mem);
+void node_clear(void *mem, size_t size, int thread_cnt);
+
+/*
+ * A block of memory that is allocated once and then handed out from front to
+ * back, everything in it is freed together.
+ */
+typedef struct {
+	char *base;
+	size_t size;
+	size_t used;
+} Arena;
+
+bool init_arena(Arena *arena, size_t size);
+void *arena_alloc(Arena *arena, size_t size);
+void reset_arena(Arena *arena);
+void free_arena(Arena *arena);
+
+/* Everything search needs for one ply, kept to whole cache lines */
+typedef struct {
+	Move moves[MAX_MOVES];
+	int scores[MAX_MOVES];
+	uint16_t move_cnt;
+
+	Move move;
+	Undo undo;
+	Value static_eval;
+
+	/* Cleared after every move, filled in the first time it is needed */
+	Attack_Info attacks;
+	Move killers[2];
+
+	uint8_t pv_len;
+	Move pv[MAX_PLY];
+} __attribute__((aligned(CACHE_LINE_SIZE))) Ply;
+
+/*
+ * The state of one search thread. All of it lives in the thread's arena so
+ * nothing gets allocated after go, and since the arena is allocated from the
+ * thread itself it ends up on that thread's node.
+ */
+struct Thread_Data {
+	int id;
+	Arena arena;
+
+	Board *board;
+
+	Ply *stack;
+	int16_t (*history)[SQ_CNT][SQ_CNT];
+
+	/* The game followed by the search path, for finding repetitions */
+	Key_History *keys;
+
+	Eval_Cache *eval_cache;
+
+	/* Set up by whoever starts the search */
+	const Search_Params *params;
+	Search_Limits limits;
+	bool uci_output;
+
+	/* Set from outside to end the search early */
+	atomic_bool stop;
+
+	uint64_t nodes;
+	int64_t start_time;
+	int root_depth;
+	int sel_depth;
+
+	/* Set while checking a null move cutoff, which is done without them */
+	bool no_null_move;
+
+	/* The result of the last completed iteration */
+	Move best_move;
+	Value best_value;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+bool init_thread_data(Thread_Data *td, int id);
+void clear_thread_data(Thread_Data *td);
+void free_thread_data(Thread_Data *td);
+
+bool init_threads();
+void start_search(Board *board, Key_History *keys, Search_Limits *limits,
+                  bool uci_output);
+void stop_search();
+void wait_search();
+void new_game();
+void quit_threads();
+uint64_t search_nodes();
+
+#ifdef DEBUG
+size_t heap_alloc_cnt();
+#endif
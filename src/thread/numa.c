@@ -0,0 +1,210 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the NUMA topology detection and the helpers used to
+ * keep each search thread, along with the memory it touches, on one node.
+ *
+ * Linux places a page on the node of the thread that first writes to it, so
+ * instead of calling into libnuma everything here relies on pinning a thread
+ * first and then having that thread be the one to zero its own memory.
+ *
+ * On machines with a single node all of this does nothing.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defs.h"
+
+#define NODE_PATH "/sys/devices/system/node"
+
+bool numa_binding = false;
+
+static int nodes;
+static cpu_set_t node_cpus[MAX_NODES];
+
+/*
+ * Parse a cpulist such as "0-15,32-47" into a cpu set.
+ * Returns the amount of cpus that were read.
+ */
+static int
+parse_cpulist(const char *str, cpu_set_t *set) {
+	int cnt = 0;
+
+	CPU_ZERO(set);
+
+	while (*str >= '0' && *str <= '9') {
+		char *end;
+		int first = strtol(str, &end, 10);
+		int last = first;
+
+		if (*end == '-')
+			last = strtol(end + 1, &end, 10);
+
+		for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, set);
+			cnt++;
+		}
+
+		if (*end != ',')
+			break;
+		str = end + 1;
+	}
+
+	return cnt;
+}
+
+/*
+ * Read the nodes out of sysfs. Nodes without any cpus (e.g. memory only
+ * nodes) are skipped since no thread can ever run on them.
+ */
+void
+init_numa() {
+	char path[64];
+	char buf[1024];
+
+	nodes = 0;
+
+	for (int n = 0; n < 1024 && nodes < MAX_NODES; n++) {
+		snprintf(path, sizeof(path), NODE_PATH "/node%d/cpulist", n);
+
+		FILE *f = fopen(path, "r");
+		if (!f)
+			continue;
+
+		if (fgets(buf, sizeof(buf), f) &&
+			parse_cpulist(buf, &node_cpus[nodes]))
+			nodes++;
+
+		fclose(f);
+	}
+
+	/* No sysfs or no information in it, treat it as a single node */
+	if (!nodes)
+		nodes = 1;
+}
+
+int
+node_cnt() {
+	return nodes;
+}
+
+/* Threads are spread over the nodes round robin */
+int
+thread_node(int thread_id) {
+	assert(thread_id >= 0);
+	return thread_id % nodes;
+}
+
+/* Pin the calling thread to all of the cpus of the node for thread_id */
+static void
+pin_thread(int thread_id) {
+	if (nodes <= 1)
+		return;
+
+	sched_setaffinity(0, sizeof(cpu_set_t), &node_cpus[thread_node(thread_id)]);
+}
+
+/* Pin a search thread, only done when the NUMA Binding option is on */
+void
+bind_thread(int thread_id) {
+	if (numa_binding)
+		pin_thread(thread_id);
+}
+
+/*
+ * Allocate cache line aligned memory and zero it from the calling thread.
+ * When the calling thread has been bound with bind_thread, that write is what
+ * places the pages on its node, so per thread tables (history, search stack)
+ * should always be allocated from inside the thread that uses them.
+ */
+void *
+node_alloc(size_t size) {
+	size = (size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+
+	void *mem = aligned_alloc(CACHE_LINE_SIZE, size);
+	if (mem)
+		memset(mem, 0, size);
+
+	return mem;
+}
+
+void
+node_free(void *mem) {
+	free(mem);
+}
+
+typedef struct {
+	char *mem;
+	size_t size;
+	int thread_id;
+} Clear_Job;
+
+static void *
+clear_slice(void *arg) {
+	Clear_Job *job = arg;
+
+	pin_thread(job->thread_id);
+	memset(job->mem, 0, job->size);
+
+	return NULL;
+}
+
+/*
+ * Zero a shared table such as the hash with one thread per search thread,
+ * each pinned to the node of the search thread with the same id. Every
+ * thread zeroes its own slice so the table ends up interleaved over the
+ * nodes rather than all on the node that happened to allocate it. The
+ * helpers are pinned even when NUMA Binding is off, since they only live for
+ * the clear and spreading the pages over the nodes is still worth it.
+ */
+void
+node_clear(void *mem, size_t size, int thread_cnt) {
+	if (nodes <= 1 || thread_cnt <= 1) {
+		memset(mem, 0, size);
+		return;
+	}
+
+	pthread_t threads[thread_cnt];
+	Clear_Job jobs[thread_cnt];
+	bool started[thread_cnt];
+
+	size_t slice = size / thread_cnt;
+
+	for (int i = 0; i < thread_cnt; i++) {
+		jobs[i].mem = (char *)mem + slice * i;
+		jobs[i].size = i == thread_cnt - 1 ? size - slice * i : slice;
+		jobs[i].thread_id = i;
+
+		started[i] = !pthread_create(&threads[i], NULL, clear_slice, &jobs[i]);
+
+		/* Still clear the slice if we could not get a thread for it */
+		if (!started[i])
+			memset(jobs[i].mem, 0, jobs[i].size);
+	}
+
+	for (int i = 0; i < thread_cnt; i++)
+		if (started[i])
+			pthread_join(threads[i], NULL);
+}
@@ -0,0 +1,175 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the search thread that the UCI loop hands searches to.
+ *
+ * The thread is started once at startup. It binds itself and sets up its
+ * own Thread_Data, so the arena ends up on its node, and then sleeps until
+ * there is a search to run. go only copies the position over and wakes it,
+ * so nothing is allocated from go until bestmove.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "defs.h"
+#include "../board/helpers.h"
+#include "../search/helpers.h"
+
+typedef enum {
+	STARTING, FAILED, IDLE, SEARCHING, QUITTING
+} Thread_State;
+
+static Thread_Data td;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static Thread_State state = STARTING;
+
+static void
+set_state(Thread_State s) {
+	pthread_mutex_lock(&lock);
+	state = s;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+static void *
+thread_loop(void *arg) {
+	(void)arg;
+
+	bind_thread(0);
+	if (!init_thread_data(&td, 0)) {
+		set_state(FAILED);
+		return NULL;
+	}
+
+	set_state(IDLE);
+
+	for (;;) {
+		pthread_mutex_lock(&lock);
+		while (state == IDLE)
+			pthread_cond_wait(&cond, &lock);
+		Thread_State s = state;
+		pthread_mutex_unlock(&lock);
+
+		if (s == QUITTING)
+			break;
+
+#ifdef DEBUG
+		size_t allocs = heap_alloc_cnt();
+#endif
+		search(&td);
+#ifdef DEBUG
+		/* Search has to run entirely out of preallocated memory */
+		if (heap_alloc_cnt() != allocs) {
+			printf("%zu heap allocations during search\n",
+				heap_alloc_cnt() - allocs);
+			exit(1);
+		}
+#endif
+
+		if (td.uci_output) {
+			char move[6] = "0000";
+
+			if (td.best_move)
+				move_str(td.best_move, move);
+			printf("bestmove %s\n", move);
+		}
+
+		set_state(IDLE);
+	}
+
+	free_thread_data(&td);
+	return NULL;
+}
+
+/* Start the search thread, returns false if it couldn't get its memory */
+bool
+init_threads() {
+	if (pthread_create(&thread, NULL, thread_loop, NULL))
+		return false;
+
+	pthread_mutex_lock(&lock);
+	while (state == STARTING)
+		pthread_cond_wait(&cond, &lock);
+	Thread_State s = state;
+	pthread_mutex_unlock(&lock);
+
+	if (s == FAILED) {
+		pthread_join(thread, NULL);
+		return false;
+	}
+
+	return true;
+}
+
+/* Wait for the search that is running, if there is one, to finish */
+void
+wait_search() {
+	pthread_mutex_lock(&lock);
+	while (state == SEARCHING)
+		pthread_cond_wait(&cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+/*
+ * Search a position in the background. The position and the keys of the
+ * game leading up to it are copied, so the caller can reuse them straight
+ * away.
+ */
+void
+start_search(Board *board, Key_History *keys, Search_Limits *limits,
+             bool uci_output) {
+	wait_search();
+
+	*td.board = *board;
+	copy_key_history(td.keys, keys);
+	td.limits = *limits;
+	td.uci_output = uci_output;
+	atomic_store(&td.stop, false);
+
+	set_state(SEARCHING);
+}
+
+void
+stop_search() {
+	atomic_store(&td.stop, true);
+}
+
+/* ucinewgame, forget the history and corrections of the last game */
+void
+new_game() {
+	wait_search();
+	clear_thread_data(&td);
+}
+
+void
+quit_threads() {
+	stop_search();
+	wait_search();
+	set_state(QUITTING);
+	pthread_join(thread, NULL);
+}
+
+/* Nodes searched by the last search, only valid once it has finished */
+uint64_t
+search_nodes() {
+	return td.nodes;
+}
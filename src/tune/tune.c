@@ -0,0 +1,624 @@
+/*
+ * This file is part of Nerd Engine
+ *
+ * Nerd Engine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nerd Engine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with Nerd Engine.	If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the Texel tuner for the evaluation weights, only built
+ * with "make tune". It is run with
+ *
+ * nerdengine tune <positions> [epochs] [threads] [output]
+ *
+ * where every line of the positions file is a fen followed by the result of
+ * the game, either as [1.0], [0.5], [0.0] or as 1-0, 1/2-1/2, 0-1. Such a
+ * file can be turned into packed records (see "board/pack.c") with
+ *
+ * nerdengine pack <positions> <output.pack>
+ *
+ * and files ending in .pack are then loaded without parsing any fens.
+ *
+ * Each fen is only parsed once while loading. After that a position is just
+ * a list of 16 bit features (colour, piece type and square) in one big
+ * array, so the evaluation is linear in the weights and its gradient is
+ * cheap. The loss is the usual mean squared error between the result and a
+ * sigmoid of the evaluation, and it is minimized with Adam over mini batches
+ * that are split between threads.
+ *
+ * The tuned weights are written out in the same layout as "eval/psqt.h".
+ */
+
+#ifdef TUNE
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "../eval/defs.h"
+#include "../eval/psqt.h"
+#include "../board/helpers.h"
+
+#define BATCH_SIZE 16384
+#define MAX_THREADS 256
+
+#define LEARNING_RATE 1.0f
+#define BETA1 0.9f
+#define BETA2 0.999f
+#define EPSILON 1e-8f
+
+/* Material weights first, then the square tables */
+#define MATERIAL_PARAMS (PHASE_CNT * PIECE_TYPE_CNT)
+#define PARAM_CNT (MATERIAL_PARAMS + PHASE_CNT * PIECE_TYPE_CNT * SQ_CNT)
+
+typedef struct {
+	uint32_t start;
+	uint8_t cnt;
+	uint8_t phase;
+	/* 0 for a black win, 1 for a draw and 2 for a white win */
+	uint8_t result;
+} Tune_Pos;
+
+typedef enum {
+	JOB_GRADIENT,
+	JOB_LOSS,
+	JOB_QUIT
+} Job;
+
+typedef struct {
+	int id;
+	double loss;
+	float grad[PARAM_CNT];
+	float scores[BATCH_SIZE];
+} __attribute__((aligned(CACHE_LINE_SIZE))) Worker;
+
+static Tune_Pos *positions;
+static uint32_t position_cnt;
+
+/* Bit 9 is the colour, bits 6-8 the piece type and bits 0-5 the square */
+static uint16_t *features;
+static uint32_t feature_cnt;
+
+static float params[PARAM_CNT];
+static float k;
+
+static int thread_cnt;
+static Worker *workers;
+static pthread_barrier_t start_barrier, done_barrier;
+
+static Job job;
+static uint32_t job_start, job_end;
+
+static inline int
+material_index(Phase ph, Piece_Type pt) {
+	return ph * PIECE_TYPE_CNT + pt;
+}
+
+static inline int
+psqt_index(Phase ph, Piece_Type pt, Square sq) {
+	return MATERIAL_PARAMS + (ph * PIECE_TYPE_CNT + pt) * SQ_CNT + sq;
+}
+
+/* Loading */
+
+static bool
+parse_result(const char *line, uint8_t *result) {
+	const char *r = strchr(line, '[');
+
+	if (r)
+		*result = (uint8_t)(atof(r + 1) * 2 + 0.5);
+	else if (strstr(line, "1/2-1/2"))
+		*result = 1;
+	else if (strstr(line, "1-0"))
+		*result = 2;
+	else if (strstr(line, "0-1"))
+		*result = 0;
+	else
+		return false;
+
+	return *result <= 2;
+}
+
+/* Fill in a position, with its features from features[start] on */
+static void
+set_position(Tune_Pos *pos, uint32_t start, Board *board, uint8_t result) {
+	pos->start  = start;
+	pos->cnt    = 0;
+	pos->phase  = game_phase(board);
+	pos->result = result;
+
+	Bitboard b = board->pieces[ALL_PIECES];
+	while (b && pos->cnt < 32) {
+		Square sq = lsb(b);
+		Piece p = board->mailbox[sq];
+		Turn t = piece_side(p);
+
+		features[start + pos->cnt++] = t << 9 | piece_type(p) << 6 |
+			(t == WHITE ? sq : sq ^ 56);
+
+		b &= b - 1;
+	}
+}
+
+static void
+add_position(Board *board, uint8_t result) {
+	static uint32_t position_cap, feature_cap;
+
+	if (position_cnt == position_cap) {
+		position_cap = position_cap ? position_cap * 2 : 1 << 16;
+		positions = realloc(positions, position_cap * sizeof(Tune_Pos));
+	}
+	if (feature_cnt + 32 >= feature_cap) {
+		feature_cap = feature_cap ? feature_cap * 2 : 1 << 20;
+		features = realloc(features, feature_cap * sizeof(uint16_t));
+	}
+
+	Tune_Pos *pos = &positions[position_cnt++];
+	set_position(pos, feature_cnt, board, result);
+	feature_cnt += pos->cnt;
+}
+
+/*
+ * Positions from a packed file are decoded on every thread at once, so each
+ * one gets a fixed slot of 32 features to write to. The slots are packed
+ * together once every position is in.
+ */
+static void
+set_packed_position(Board *board, uint8_t result, size_t index, void *arg) {
+	(void)arg;
+
+	if (result <= 2)
+		set_position(&positions[index], index * 32, board, result);
+}
+
+static bool
+load_packed_positions(const char *path) {
+	Packed_File pf;
+
+	if (!open_packed_file(&pf, path))
+		return false;
+
+	size_t cnt = pf.cnt < UINT32_MAX / 32 ? pf.cnt : UINT32_MAX / 32;
+
+	positions = malloc(cnt * sizeof(Tune_Pos));
+	features  = malloc(cnt * 32 * sizeof(uint16_t));
+
+	/* Records that don't decode keep an invalid result and are dropped */
+	for (size_t i = 0; i < cnt; i++)
+		positions[i].result = 3;
+
+	pf.cnt = cnt;
+	decode_packed_file(&pf, thread_cnt, set_packed_position, NULL);
+	close_packed_file(&pf);
+
+	/* Close up the gaps left by dropped records and unused feature slots */
+	for (size_t i = 0; i < cnt; i++) {
+		Tune_Pos *pos = &positions[i];
+
+		if (pos->result > 2)
+			continue;
+
+		memmove(&features[feature_cnt], &features[pos->start],
+			pos->cnt * sizeof(uint16_t));
+		pos->start = feature_cnt;
+		feature_cnt += pos->cnt;
+
+		positions[position_cnt++] = *pos;
+	}
+
+	if (feature_cnt)
+		features = realloc(features, feature_cnt * sizeof(uint16_t));
+
+	return position_cnt > 0;
+}
+
+static bool
+load_positions(const char *path) {
+	char line[1024];
+	Board board;
+	uint8_t result;
+
+	size_t len = strlen(path);
+	if (len > 5 && !strcmp(path + len - 5, ".pack"))
+		return load_packed_positions(path);
+
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return false;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (!parse_result(line, &result))
+			continue;
+
+		clear_board(&board);
+		parse_fen(&board, line);
+		add_position(&board, result);
+	}
+
+	fclose(f);
+
+	return position_cnt > 0;
+}
+
+/* Shuffle so that positions from the same game don't share a batch */
+static void
+shuffle_positions() {
+	srand(time(NULL));
+
+	for (uint32_t i = position_cnt - 1; i > 0; i--) {
+		uint32_t j = ((uint64_t)rand() * RAND_MAX + rand()) % (i + 1);
+		Tune_Pos tmp = positions[i];
+		positions[i] = positions[j];
+		positions[j] = tmp;
+	}
+}
+
+/* Evaluation, gradient and loss */
+
+static inline float
+tune_eval(Tune_Pos *pos) {
+	float score[PHASE_CNT] = { 0, 0 };
+
+	for (int i = 0; i < pos->cnt; i++) {
+		uint16_t f = features[pos->start + i];
+		Piece_Type pt = (f >> 6) & 7;
+		float sign = f >> 9 ? -1.0f : 1.0f;
+
+		for (Phase ph = MG; ph <= EG; ph++)
+			score[ph] += sign * (params[material_index(ph, pt)] +
+				params[psqt_index(ph, pt, f & 63)]);
+	}
+
+	return (score[MG] * pos->phase + score[EG] * (PHASE_MAX - pos->phase)) /
+		PHASE_MAX;
+}
+
+static void
+worker_run(Worker *w) {
+	uint32_t len   = job_end - job_start;
+	uint32_t chunk = (len + thread_cnt - 1) / thread_cnt;
+	uint32_t start = job_start + chunk * w->id;
+	uint32_t end   = start + chunk < job_end ? start + chunk : job_end;
+
+	float *scores = w->scores;
+	double loss = 0;
+
+	if (job == JOB_GRADIENT)
+		memset(w->grad, 0, sizeof(w->grad));
+
+	while (start < end) {
+		uint32_t n = end - start < BATCH_SIZE ? end - start : BATCH_SIZE;
+
+		for (uint32_t i = 0; i < n; i++)
+			scores[i] = tune_eval(&positions[start + i]);
+
+		/*
+		 * Turn the scores into the loss and the derivative of the loss
+		 * in place, kept apart from the gathering above so it vectorizes.
+		 */
+		for (uint32_t i = 0; i < n; i++) {
+			float r = positions[start + i].result * 0.5f;
+			float s = 1.0f / (1.0f + expf(-k * scores[i]));
+
+			loss += (r - s) * (r - s);
+			scores[i] = -2.0f * (r - s) * s * (1.0f - s) * k;
+		}
+
+		if (job == JOB_GRADIENT) {
+			for (uint32_t i = 0; i < n; i++) {
+				Tune_Pos *pos = &positions[start + i];
+
+				float mg = scores[i] * pos->phase / PHASE_MAX;
+				float eg = scores[i] * (PHASE_MAX - pos->phase) / PHASE_MAX;
+
+				for (int j = 0; j < pos->cnt; j++) {
+					uint16_t f = features[pos->start + j];
+					Piece_Type pt = (f >> 6) & 7;
+					float sign = f >> 9 ? -1.0f : 1.0f;
+
+					w->grad[material_index(MG, pt)] += sign * mg;
+					w->grad[material_index(EG, pt)] += sign * eg;
+					w->grad[psqt_index(MG, pt, f & 63)] += sign * mg;
+					w->grad[psqt_index(EG, pt, f & 63)] += sign * eg;
+				}
+			}
+		}
+
+		start += n;
+	}
+
+	w->loss = loss;
+}
+
+static void *
+worker_loop(void *arg) {
+	Worker *w = arg;
+
+	for (;;) {
+		pthread_barrier_wait(&start_barrier);
+
+		if (job == JOB_QUIT)
+			return NULL;
+
+		worker_run(w);
+
+		pthread_barrier_wait(&done_barrier);
+	}
+}
+
+/* Hand out a job on positions [start, end) to every thread and wait */
+static double
+run_job(Job j, uint32_t start, uint32_t end) {
+	double loss = 0;
+
+	job = j;
+	job_start = start;
+	job_end = end;
+
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&done_barrier);
+
+	for (int i = 0; i < thread_cnt; i++)
+		loss += workers[i].loss;
+
+	return loss / (end - start);
+}
+
+/*
+ * Find the scaling constant of the sigmoid that fits the current weights
+ * best, stepping through it with finer and finer steps.
+ */
+static void
+fit_k() {
+	float best = 1.0f / 200.0f;
+	float step = best;
+
+	for (int round = 0; round < 6; round++, step /= 4) {
+		float centre = best;
+		double best_loss = 1e9;
+
+		for (int i = -4; i <= 4; i++) {
+			k = centre + i * step / 4;
+			if (k <= 0)
+				continue;
+
+			double loss = run_job(JOB_LOSS, 0, position_cnt);
+			if (loss < best_loss) {
+				best_loss = loss;
+				best = k;
+			}
+		}
+	}
+
+	k = best;
+}
+
+/* Output */
+
+static void
+write_header(const char *path) {
+	static const char *names[PIECE_TYPE_CNT] = {
+		"No piece", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King"
+	};
+
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		printf("Could not write %s\n", path);
+		return;
+	}
+
+	fprintf(f,
+"/*\n"
+" * This file is part of Nerd Engine\n"
+" *\n"
+" * Nerd Engine is free software: you can redistribute it and/or modify\n"
+" * it under the terms of the GNU General Public License as published by\n"
+" * the Free Software Foundation, either version 3 of the License, or\n"
+" * (at your option) any later version.\n"
+" *\n"
+" * Nerd Engine is distributed in the hope that it will be useful,\n"
+" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the\n"
+" * GNU General Public License for more details.\n"
+" *\n"
+" * You should have recieved a copy of the GNU General Public License\n"
+" * along with Nerd Engine.\tIf not, see <https://www.gnu.org/licenses/>.\n"
+" */\n"
+"\n"
+"/*\n"
+" * Evaluation weights, this file is written by the tuner in \"tune/tune.c\".\n"
+" * The square tables are from white's point of view starting at A1.\n"
+" */\n"
+"#pragma once\n"
+"\n"
+"#include \"defs.h\"\n"
+"\n"
+"static const Value piece_values[PHASE_CNT][PIECE_TYPE_CNT] = {\n");
+
+	for (Phase ph = MG; ph <= EG; ph++) {
+		fprintf(f, "\t{ ");
+		for (Piece_Type pt = 0; pt < PIECE_TYPE_CNT; pt++)
+			fprintf(f, "%d%s", (int)lroundf(params[material_index(ph, pt)]),
+				pt == KING ? " },\n" : ", ");
+	}
+
+	fprintf(f, "};\n\n"
+		"static const Value psqt[PHASE_CNT][PIECE_TYPE_CNT][SQ_CNT] = {\n");
+
+	for (Phase ph = MG; ph <= EG; ph++) {
+		fprintf(f, "\t{\n");
+		for (Piece_Type pt = 0; pt < PIECE_TYPE_CNT; pt++) {
+			fprintf(f, "\t\t/* %s */\n\t\t{\n", names[pt]);
+			for (Square sq = A1; sq <= H8; sq++)
+				fprintf(f, "%s%4d,%s", file(sq) == FILE_A ? "\t\t\t" : " ",
+					(int)lroundf(params[psqt_index(ph, pt, sq)]),
+					file(sq) == FILE_H ? "\n" : "");
+			fprintf(f, "\t\t},\n");
+		}
+		fprintf(f, "\t},\n");
+	}
+
+	fprintf(f, "};\n");
+	fclose(f);
+}
+
+int
+pack(int argc, char **argv) {
+	char line[1024];
+	Board board;
+	Packed_Board pb;
+	uint8_t result;
+	size_t cnt = 0;
+
+	if (argc < 3) {
+		printf("Usage: pack <positions> <output>\n");
+		return 1;
+	}
+
+	FILE *in = fopen(argv[1], "r");
+	if (!in) {
+		printf("Could not open %s\n", argv[1]);
+		return 1;
+	}
+
+	FILE *out = fopen(argv[2], "wb");
+	if (!out) {
+		printf("Could not open %s\n", argv[2]);
+		fclose(in);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in)) {
+		if (!parse_result(line, &result))
+			continue;
+
+		clear_board(&board);
+		parse_fen(&board, line);
+
+		if (pack_board(&board, result, &pb) && fwrite(&pb, sizeof(pb), 1, out))
+			cnt++;
+	}
+
+	fclose(in);
+	fclose(out);
+
+	printf("Packed %zu positions\n", cnt);
+
+	return 0;
+}
+
+int
+tune(int argc, char **argv) {
+	if (argc < 2) {
+		printf("Usage: tune <positions> [epochs] [threads] [output]\n");
+		return 1;
+	}
+
+	int epochs = argc > 2 ? atoi(argv[2]) : 20;
+	const char *output = argc > 4 ? argv[4] : "psqt.h";
+
+	thread_cnt = argc > 3 ? atoi(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+	if (thread_cnt < 1)
+		thread_cnt = 1;
+	if (thread_cnt > MAX_THREADS)
+		thread_cnt = MAX_THREADS;
+
+	if (!load_positions(argv[1])) {
+		printf("Could not load any positions from %s\n", argv[1]);
+		return 1;
+	}
+	printf("Loaded %u positions (%zu MB)\n", position_cnt,
+		(position_cnt * sizeof(Tune_Pos) + feature_cnt * sizeof(uint16_t)) >> 20);
+
+	shuffle_positions();
+
+	/* Start from the weights the engine uses now */
+	for (Phase ph = MG; ph <= EG; ph++)
+		for (Piece_Type pt = 0; pt < PIECE_TYPE_CNT; pt++) {
+			params[material_index(ph, pt)] = piece_values[ph][pt];
+			for (Square sq = A1; sq <= H8; sq++)
+				params[psqt_index(ph, pt, sq)] = psqt[ph][pt][sq];
+		}
+
+	/* Each worker starts on its own cache line so their sums don't collide */
+	workers = aligned_alloc(CACHE_LINE_SIZE, thread_cnt * sizeof(Worker));
+	if (!workers) {
+		printf("Could not allocate %d workers\n", thread_cnt);
+		return 1;
+	}
+
+	pthread_t threads[thread_cnt];
+
+	pthread_barrier_init(&start_barrier, NULL, thread_cnt + 1);
+	pthread_barrier_init(&done_barrier, NULL, thread_cnt + 1);
+
+	for (int i = 0; i < thread_cnt; i++) {
+		workers[i].id = i;
+		pthread_create(&threads[i], NULL, worker_loop, &workers[i]);
+	}
+
+	fit_k();
+	printf("K = %f, loss %.6f\n", k, run_job(JOB_LOSS, 0, position_cnt));
+
+	static float m[PARAM_CNT], v[PARAM_CNT];
+	int step = 0;
+
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		for (uint32_t start = 0; start < position_cnt; start += BATCH_SIZE) {
+			uint32_t end = start + BATCH_SIZE < position_cnt ?
+				start + BATCH_SIZE : position_cnt;
+
+			run_job(JOB_GRADIENT, start, end);
+			step++;
+
+			float lr = LEARNING_RATE * sqrtf(1 - powf(BETA2, step)) /
+				(1 - powf(BETA1, step));
+
+			for (int i = 0; i < PARAM_CNT; i++) {
+				float g = 0;
+
+				for (int t = 0; t < thread_cnt; t++)
+					g += workers[t].grad[i];
+				g /= end - start;
+
+				m[i] = BETA1 * m[i] + (1 - BETA1) * g;
+				v[i] = BETA2 * v[i] + (1 - BETA2) * g * g;
+
+				params[i] -= lr * m[i] / (sqrtf(v[i]) + EPSILON);
+			}
+		}
+
+		printf("Epoch %d loss %.6f\n", epoch,
+			run_job(JOB_LOSS, 0, position_cnt));
+
+		write_header(output);
+	}
+
+	job = JOB_QUIT;
+	pthread_barrier_wait(&start_barrier);
+	for (int i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+
+	free(workers);
+	free(positions);
+	free(features);
+
+	return 0;
+}
+
+#endif